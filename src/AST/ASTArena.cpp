@@ -0,0 +1,30 @@
+#include <cstdint>
+
+#include "ASTArena.h"
+#include "AbstractSyntaxTree.h"
+
+void* ASTArena::Allocate(const size_t size, const size_t align)
+{
+    std::byte* start = cursor ? cursor + (align - reinterpret_cast<uintptr_t>(cursor) % align) % align : nullptr;
+    if (!start || start + size > blockEnd)
+    {
+        // Left uninitialised, operator new[] aligns it for anything a node holds
+        blocks.emplace_back(new std::byte[blockSize]);
+        start = blocks.back().get();
+        blockEnd = start + blockSize;
+    }
+    cursor = start + size;
+    bytesUsed += size;
+    return start;
+}
+
+void ASTArena::Reset()
+{
+    // Children are plain pointers into the arena, so no destructor reaches past its own node
+    for (ASTNode* node : nodes) node->~ASTNode();
+    nodes.clear();
+    bytesUsed = 0;
+    if (blocks.size() > 1) blocks.resize(1);
+    cursor   = blocks.empty() ? nullptr : blocks.front().get();
+    blockEnd = blocks.empty() ? nullptr : cursor + blockSize;
+}
\ No newline at end of file
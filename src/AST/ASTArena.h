@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class ASTNode;
+
+// Bump allocator the parser builds a whole tree in. Nodes are laid out one after the other in the order
+// they were parsed (which is also their index) and never freed on their own, Reset destroys all of them
+// in a single flat pass (no recursion down the tree) and hands the memory back at once.
+class ASTArena
+{
+private:
+    // Every node fits in a block many times over
+    static constexpr size_t blockSize = 64 * 1024;
+
+    std::vector<std::unique_ptr<std::byte[]>> blocks;
+    std::byte* cursor = nullptr;
+    std::byte* blockEnd = nullptr;
+    // Nodes in allocation order, to run their destructors on Reset
+    std::vector<ASTNode*> nodes;
+    size_t bytesUsed = 0;
+
+    void* Allocate(const size_t size, const size_t align);
+public:
+    ASTArena() = default;
+    ASTArena(const ASTArena&) = delete;
+    ASTArena& operator=(const ASTArena&) = delete;
+    ~ASTArena() { Reset(); }
+
+    template<typename T, typename... Args>
+    T* Make(Args&&... args)
+    {
+        static_assert(std::is_base_of_v<ASTNode, T>, "Only AST nodes live in the arena");
+        static_assert(sizeof(T) <= blockSize);
+        T* node = new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        node->index = static_cast<uint32_t>(nodes.size());
+        nodes.push_back(node);
+        return node;
+    }
+
+    // Destroys every node. The first block is kept for the next tree, the rest are released
+    void Reset();
+
+    // Every node made since the last Reset, in allocation order
+    const std::vector<ASTNode*>& GetNodes() const { return nodes; }
+    size_t GetNodeCount()  const { return nodes.size(); }
+    size_t GetBlockCount() const { return blocks.size(); }
+    size_t GetBytesUsed()  const { return bytesUsed; }
+    double GetNodesPerBlock() const { return blocks.empty() ? 0.0 : static_cast<double>(nodes.size()) / blocks.size(); }
+    double GetBytesPerNode()  const { return nodes.empty()  ? 0.0 : static_cast<double>(bytesUsed) / nodes.size(); }
+};
\ No newline at end of file
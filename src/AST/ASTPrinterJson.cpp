@@ -4,11 +4,10 @@
 #include "ASTPrinterJson.h"
 #include "AbstractSyntaxTree.h"
 #include "../Util/Logger.h"
-#include "../Util/Utility.h"
 
 void ASTPrinterJson::PrintAST()
 {
-    if (!root) return;
+    if (!root && (!flat || flat->empty())) return;
 
     out.open("AST.js");
 
@@ -19,13 +18,14 @@ void ASTPrinterJson::PrintAST()
         return;
     }
 
-    // First node is the parent of all other nodes and doesnt have a parent itself, its parentID is itself
-    root->parentID = GenerateJSONHeader(out, root, "ROOT", config);
+    // First node is the parent of all other nodes and doesnt have a parent itself, its parentID is itself.
     // The next node in line will look for this one's id and that is why it's value is set to its own id rather than null
-    root->SetChildrenPrintID(root->parentID);
+    parents.clear();
+    parents.emplace_back(FlatAST::none, GenerateJSONHeader(out, "ROOT", config));
 
-    // Recursively visit each of the tree's nodes and print JSON to file
-    root->Accept(*this);
+    // Walk each of the tree's nodes and print JSON to file
+    if (root) walker.Walk(*root, [this](ASTNode& n, ASTNode*) { Dispatch(*this, n); return true; }, [this](ASTNode& n, ASTNode*) { Close(n.index); });
+    else      walker.Walk(*flat, 0, [this](const NodeIndex i, const NodeIndex parent) { PrintFlatNode(i, parent); return true; }, [this](const NodeIndex i, NodeIndex) { Close(i); });
 
     // Footer of the file must be a configuration list of all the nodes and their ids
     GenerateJSONFooter(out, config);
@@ -33,135 +33,100 @@ void ASTPrinterJson::PrintAST()
     Logger::Info("AST Visualisation File Successfully created\n");
 }
 
-std::string ASTPrinterJson::GenerateJSONHeader(std::ofstream& out, const ASTNode* root, const char* rootID, std::vector<std::string>& config) const
+void ASTPrinterJson::Update(SyntaxTree* ast)
+{
+    root = ast->root;
+    flat = &ast->flat;
+    tokens = ast->tokens.get();
+}
+
+JsonID ASTPrinterJson::GenerateJSONHeader(std::ofstream& out, const char* rootID, std::vector<JsonID>& config) const
 {
     out << "config = {\n\tcontainer: \"#AST\"\n};\n\n";
-    config.push_back("config");
-    const std::string id = Util::GenerateID(root, rootID);
+    config.push_back({ "config" });
+    const JsonID id{ rootID };
     out << id << " = {\n\ttext: { name: \"ROOT\" }\n};\n\n";
     config.push_back(id);
     return id;
 }
 
-void ASTPrinterJson::GenerateJSONFooter(std::ofstream& out, const std::vector<std::string>& config) const
+void ASTPrinterJson::GenerateJSONFooter(std::ofstream& out, const std::vector<JsonID>& config) const
 {
     out << "simple_chart_config = [\n    ";
     for (unsigned int i = 0; i < config.size(); ++i) { if (i != 0) out << ", "; out << config.at(i); }
     out << "\n];";
 }
 
-std::string ASTPrinterJson::GenerateJSON(std::ofstream& out, const ASTNode* node, const char* ID, const std::string& parentID, const std::string& name, std::vector<std::string>& config) const
+JsonID ASTPrinterJson::GenerateJSON(std::ofstream& out, const NodeIndex node, const char* ID, const JsonID parentID, const std::string_view name, std::vector<JsonID>& config) const
 {
-    const std::string nodeID = Util::GenerateID(node, ID);
+    const JsonID nodeID{ ID, node };
     out << nodeID << " = {\n\tparent: " << parentID <<
         ",\n\ttext: { name: \"" << name << "\" }\n};\n\n";
     config.push_back(nodeID);
     return nodeID;
 }
 
-void ASTPrinterJson::Visit(ASTNode& n)       { assert(("ASTVisualizer visited base ASTNode class?!"      , false)); }
-void ASTPrinterJson::Visit(UnaryASTNode& n)  { assert(("ASTVisualizer visited base UnaryASTNode class?!" , false)); }
-void ASTPrinterJson::Visit(BinaryASTNode& n) { assert(("ASTVisualizer visited base BinaryASTNode class?!", false)); }
-
-void ASTPrinterJson::Visit(IntegerNode& n)
+void ASTPrinterJson::Close(const NodeIndex key)
 {
-    (void)GenerateJSON(out, &n, "INT", n.parentID, std::to_string(n.value), config);
+    if (parents.back().first == key) parents.pop_back();
 }
 
-void ASTPrinterJson::Visit(IdentifierNode& n)
-{
-    (void)GenerateJSON(out, &n, "ID", n.parentID, n.token.str, config);
-}
 
-void ASTPrinterJson::Visit(UnaryOperationNode& n)
-{
-    n.SetChildrenPrintID(GenerateJSON(out, &n, "UNARY", n.parentID, n.op.str, config));
-    n.expr->Accept(*this);
-}
-
-void ASTPrinterJson::Visit(BinaryOperationNode& n)
-{
-    n.SetChildrenPrintID(GenerateJSON(out, &n, "BINOP", n.parentID, n.op.str, config));
-    n.left->Accept(*this);
-    n.right->Accept(*this);
-}
-
-void ASTPrinterJson::Visit(ConditionNode& n)
-{
-    n.SetChildrenPrintID(GenerateJSON(out, &n, "COND", n.parentID, n.op.str, config));
-    n.left->Accept(*this);
-    n.right->Accept(*this);
-}
+void ASTPrinterJson::Visit(IntegerNode& n)          { Open(n.index, GenerateJSON(out, n.index, "INT",         ParentID(), std::to_string(n.value), config)); }
+void ASTPrinterJson::Visit(IdentifierNode& n)       { Open(n.index, GenerateJSON(out, n.index, "ID",          ParentID(), (*tokens)[n.token].str,  config)); }
+void ASTPrinterJson::Visit(UnaryOperationNode& n)   { Open(n.index, GenerateJSON(out, n.index, "UNARY",       ParentID(), (*tokens)[n.op].str,     config)); }
+void ASTPrinterJson::Visit(BinaryOperationNode& n)  { Open(n.index, GenerateJSON(out, n.index, "BINOP",       ParentID(), (*tokens)[n.op].str,     config)); }
+void ASTPrinterJson::Visit(ConditionNode& n)        { Open(n.index, GenerateJSON(out, n.index, "COND",        ParentID(), (*tokens)[n.op].str,     config)); }
+void ASTPrinterJson::Visit(DeclareStatementNode& n) { Open(n.index, GenerateJSON(out, n.index, "DECL",        ParentID(), (*tokens)[n.type].str,   config)); }
+void ASTPrinterJson::Visit(DeclareAssignNode& n)    { Open(n.index, GenerateJSON(out, n.index, "DECL_ASSIGN", ParentID(), (*tokens)[n.op].str,     config)); }
+void ASTPrinterJson::Visit(AssignStatementNode& n)  { Open(n.index, GenerateJSON(out, n.index, "ASSIGN",      ParentID(), (*tokens)[n.op].str,     config)); }
+void ASTPrinterJson::Visit(ReturnStatementNode& n)  { Open(n.index, GenerateJSON(out, n.index, "RETURN",      ParentID(), "RETURN",                config)); }
 
 void ASTPrinterJson::Visit(IfNode& n)
 {
-    n.SetChildrenPrintID(GenerateJSON(out, &n, n.type.c_str(), n.parentID, n.type.c_str(), config));
-    n.condition->Accept(*this);
-    if (n.body) n.body->Accept(*this);
+    const char* type = n.elseIf ? "ELSEIF" : "IF";
+    Open(n.index, GenerateJSON(out, n.index, type, ParentID(), type, config));
 }
 
-void ASTPrinterJson::Visit(IfStatementNode& n)
-{
-    n.SetChildrenPrintID(GenerateJSON(out, &n, "_IF_", n.parentID, "_IF_", config));  // else is compound so parent automatically becomes _IF_ shows no else!
-    for (const auto& ifN : n.ifNodes) ifN->Accept(*this);
-    if (n.elseBody) n.elseBody->Accept(*this);
-}
+// else is compound so parent automatically becomes _IF_ shows no else!
+void ASTPrinterJson::Visit(IfStatementNode& n)      { Open(n.index, GenerateJSON(out, n.index, "_IF_", ParentID(), "_IF_", config)); }
 
-void ASTPrinterJson::Visit(IterationNode& n) { assert(("ASTVisualizer visited base IterationNode class?!", false)); }
-void ASTPrinterJson::Visit(WhileNode& n)
-{
-    n.SetChildrenPrintID(GenerateJSON(out, &n, "WHILE", n.parentID, "WHILE", config));
-    n.condition->Accept(*this);
-    if (n.body) n.body->Accept(*this);
-}
+void ASTPrinterJson::Visit(WhileNode& n)            { Open(n.index, GenerateJSON(out, n.index, "WHILE", ParentID(), "WHILE", config)); }
+void ASTPrinterJson::Visit(DoWhileNode& n)          { Open(n.index, GenerateJSON(out, n.index, "DO",    ParentID(), "DO",    config)); }
 
-void ASTPrinterJson::Visit(DoWhileNode& n)
-{
-    n.SetChildrenPrintID(GenerateJSON(out, &n, "DO", n.parentID, "DO", config));
-    if (n.body) n.body->Accept(*this);
-    n.condition->Accept(*this);
-}
+// Each child of the compound has this compound as a parent (but we never visualise compound statements)
+// so the parent of the children is in fact the parent of the compound node
+void ASTPrinterJson::Visit(CompoundStatementNode& n) {}
+void ASTPrinterJson::Visit(StatementBlockNode& n)    {}
 
-void ASTPrinterJson::Visit(CompoundStatementNode& n)
-{
-    // Each child of the compound has this compound as a parent (but we never visualise compound statements)
-    // so the parent of the children is in fact the parent of the compound node
-    n.SetChildrenPrintID(n.parentID);
-    for (const auto& statement : n.statements) statement->Accept(*this);
-}
-
-void ASTPrinterJson::Visit(StatementBlockNode& n)
-{
-    // Each child of the compound has this compound as a parent (but we never visualise compound statements)
-    // so the parent of the children is in fact the parent of the compound node
-    n.SetChildrenPrintID(n.parentID);
-    for (const auto& statement : n.statements) statement->Accept(*this);
-}
-
-void ASTPrinterJson::Visit(DeclareStatementNode& n)
-{
-    n.SetChildrenPrintID(GenerateJSON(out, &n, "DECL", n.parentID, n.type.str, config));
-    n.identifier->Accept(*this);
-}
-
-void ASTPrinterJson::Visit(DeclareAssignNode& n)
-{
-    n.SetChildrenPrintID(GenerateJSON(out, &n, "DECL_ASSIGN", n.parentID, n.op.str, config));
-    n.left->Accept(*this);
-    n.right->Accept(*this);
-}
+void ASTPrinterJson::Visit(EmptyStatementNode& n) {}
 
-void ASTPrinterJson::Visit(AssignStatementNode& n)
+void ASTPrinterJson::PrintFlatNode(const NodeIndex i, const NodeIndex parent)
 {
-    n.SetChildrenPrintID(GenerateJSON(out, &n, "ASSIGN", n.parentID, n.op.str, config));
-    n.left->Accept(*this);
-    n.right->Accept(*this);
-}
-
-void ASTPrinterJson::Visit(ReturnStatementNode& n)
-{
-    n.SetChildrenPrintID(GenerateJSON(out, &n, "RETURN", n.parentID, "RETURN", config));
-    n.expr->Accept(*this);
-}
-
-void ASTPrinterJson::Visit(EmptyStatementNode& n) {}
\ No newline at end of file
+    const FlatNode& n = (*flat)[i];
+    switch (n.kind)
+    {
+    case NodeKind::Integer:           Open(i, GenerateJSON(out, i, "INT",         ParentID(), std::to_string(flat->GetValue(i)), config)); return;
+    case NodeKind::Identifier:        Open(i, GenerateJSON(out, i, "ID",          ParentID(), (*tokens)[n.token].str, config)); return;
+    case NodeKind::UnaryOperation:    Open(i, GenerateJSON(out, i, "UNARY",       ParentID(), (*tokens)[n.token].str, config)); return;
+    case NodeKind::BinaryOperation:   Open(i, GenerateJSON(out, i, "BINOP",       ParentID(), (*tokens)[n.token].str, config)); return;
+    case NodeKind::Condition:         Open(i, GenerateJSON(out, i, "COND",        ParentID(), (*tokens)[n.token].str, config)); return;
+    case NodeKind::DeclareStatement:  Open(i, GenerateJSON(out, i, "DECL",        ParentID(), (*tokens)[n.token].str, config)); return;
+    case NodeKind::DeclareAssign:     Open(i, GenerateJSON(out, i, "DECL_ASSIGN", ParentID(), (*tokens)[n.token].str, config)); return;
+    case NodeKind::AssignStatement:   Open(i, GenerateJSON(out, i, "ASSIGN",      ParentID(), (*tokens)[n.token].str, config)); return;
+    case NodeKind::IfStatement:       Open(i, GenerateJSON(out, i, "_IF_",        ParentID(), "_IF_",   config)); return;
+    case NodeKind::While:             Open(i, GenerateJSON(out, i, "WHILE",       ParentID(), "WHILE",  config)); return;
+    case NodeKind::DoWhile:           Open(i, GenerateJSON(out, i, "DO",          ParentID(), "DO",     config)); return;
+    case NodeKind::ReturnStatement:   Open(i, GenerateJSON(out, i, "RETURN",      ParentID(), "RETURN", config)); return;
+    case NodeKind::If:
+    {
+        const char* type = (*flat)[parent].firstChild == i ? "IF" : "ELSEIF";
+        Open(i, GenerateJSON(out, i, type, ParentID(), type, config));
+        return;
+    }
+    // Compound statements are never visualised, their children hang off the compound's parent
+    case NodeKind::CompoundStatement:
+    case NodeKind::StatementBlock:
+    case NodeKind::EmptyStatement:    return;
+    }
+}
\ No newline at end of file
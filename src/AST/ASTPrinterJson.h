@@ -1,45 +1,69 @@
 #pragma once
+#include <ostream>
+#include <string>
 #include <vector>
 
+#include "ASTWalker.h"
 #include "Visitor.h"
 #include "../Util/ModuleManager.h"
 
-class ASTPrinterJson : public ASTNodeVisitor, public IObserver<ASTNode>
+// Variable name of a printed node in AST.js, its tag followed by the node's ID (index), spelled out only as it is written
+struct JsonID
+{
+    const char* tag;
+    NodeIndex node = FlatAST::none;  // Tag alone for the root and config, which are not nodes
+};
+
+inline std::ostream& operator<<(std::ostream& os, const JsonID& id)
+{
+    os << id.tag;
+    if (id.node != FlatAST::none) os << id.node;
+    return os;
+}
+
+class ASTPrinterJson : public IObserver<SyntaxTree>
 {
 private:
-    std::vector<std::string> config;
+    std::vector<JsonID> config;
     std::ofstream out;
 
     ASTNode* root = nullptr;
+    const FlatAST* flat = nullptr;
+    const TokenStream* tokens = nullptr;
+    ASTWalker walker;
+    // Ids of the printed nodes on the path to the one being walked, with the node each was printed for.
+    // The last is the parent of whatever is printed next, compound statements not being printed themselves
+    std::vector<std::pair<NodeIndex, JsonID>> parents;
 
-    std::string GenerateJSONHeader(std::ofstream& out, const ASTNode* root, const char* rootID, std::vector<std::string>& config) const;
-    void GenerateJSONFooter(std::ofstream& out, const std::vector<std::string>& config) const;
-    std::string GenerateJSON(std::ofstream& out, const ASTNode* node, const char* ID, const std::string& parentID, const std::string& name, std::vector<std::string>& config) const;
+    JsonID GenerateJSONHeader(std::ofstream& out, const char* rootID, std::vector<JsonID>& config) const;
+    void GenerateJSONFooter(std::ofstream& out, const std::vector<JsonID>& config) const;
+    JsonID GenerateJSON(std::ofstream& out, const NodeIndex node, const char* ID, const JsonID parentID, const std::string_view name, std::vector<JsonID>& config) const;
+    JsonID ParentID() const                             { return parents.back().second; }
+    void Open(const NodeIndex key, const JsonID id)     { parents.emplace_back(key, id); }
+    void Close(const NodeIndex key);  // Done with key's children
+    // Prints node i of the FlatAST
+    void PrintFlatNode(const NodeIndex i, const NodeIndex parent);
 public:
     void PrintAST();
 
-    // Inherited via ASTNodeVisitor
-    void Visit(ASTNode& n)               override;
-    void Visit(UnaryASTNode& n)          override;
-    void Visit(BinaryASTNode& n)         override;
-    void Visit(IntegerNode& n)           override;
-    void Visit(IdentifierNode& n)        override;
-    void Visit(UnaryOperationNode& n)    override;
-    void Visit(BinaryOperationNode& n)   override;
-    void Visit(ConditionNode& n)         override;
-    void Visit(IfNode& n)                override;
-    void Visit(IfStatementNode& n)       override;
-    void Visit(IterationNode& n)         override;
-    void Visit(WhileNode& n)             override;
-    void Visit(DoWhileNode& n)           override;
-    void Visit(StatementBlockNode& n)    override;
-    void Visit(CompoundStatementNode& n) override;
-    void Visit(DeclareStatementNode& n)  override;
-    void Visit(DeclareAssignNode& n)     override;
-    void Visit(AssignStatementNode& n)   override;
-    void Visit(ReturnStatementNode& n)   override;
-    void Visit(EmptyStatementNode& n)    override;
+    // Visited through Dispatch
+    void Visit(IntegerNode& n);
+    void Visit(IdentifierNode& n);
+    void Visit(UnaryOperationNode& n);
+    void Visit(BinaryOperationNode& n);
+    void Visit(ConditionNode& n);
+    void Visit(IfNode& n);
+    void Visit(IfStatementNode& n);
+    void Visit(WhileNode& n);
+    void Visit(DoWhileNode& n);
+    void Visit(StatementBlockNode& n);
+    void Visit(CompoundStatementNode& n);
+    void Visit(DeclareStatementNode& n);
+    void Visit(DeclareAssignNode& n);
+    void Visit(AssignStatementNode& n);
+    void Visit(ReturnStatementNode& n);
+    void Visit(EmptyStatementNode& n);
 
     // Inherited via IObserver
-    virtual void Update(ASTNode* n)      override { root = n; }
+    virtual void Update(SyntaxTree* ast) override;
 };
\ No newline at end of file
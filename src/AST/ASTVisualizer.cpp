@@ -3,11 +3,18 @@
 #include "ASTVisualizer.h"
 #include "AbstractSyntaxTree.h"
 
+void ASTVisualizer::Update(SyntaxTree* ast)
+{
+    root = ast->root;
+    flat = &ast->flat;
+    tokens = ast->tokens.get();
+}
+
 void ASTVisualizer::RenderAST()
 {
     open_action = -1;
     ImGui::Begin("Parser Output");
-    if (root)
+    if (root || (flat && !flat->empty()))
     {
         if (ImGui::Button("Expand AST"))   open_action = 1; ImGui::SameLine();
         if (ImGui::Button("Collapse AST")) open_action = 0; ImGui::SameLine();
@@ -18,61 +25,58 @@ void ASTVisualizer::RenderAST()
         ImGui::Separator();
 
         ImGui::BeginChild("AST");
-        nodeRect = RenderNode([&]() {root->Accept(*this); }, (void*)(intptr_t)&root, "ROOT");
+        openNodes.clear();
+        if (BeginNode(FlatAST::none, (void*)(intptr_t)&root, "ROOT"))
+        {
+            if (root) walker.Walk(*root, [this](ASTNode& n, ASTNode*) { descend = true; Dispatch(*this, n); return descend; }, [this](ASTNode& n, ASTNode*) { EndNode(n.index); });
+            else      walker.Walk(*flat, 0, [this](const NodeIndex i, const NodeIndex parent) { return RenderFlatNode(i, parent); }, [this](const NodeIndex i, NodeIndex) { EndNode(i); });
+            EndNode(FlatAST::none);
+        }
         ImGui::EndChild();
     }
     ImGui::End();
 }
 
 template<class ...Args>
-ASTVisualizer::ImRect ASTVisualizer::RenderNode(std::function<void()> visitCallback, void* n, const char* fmt, Args... args)
+bool ASTVisualizer::BeginNode(const NodeIndex key, void* n, const char* fmt, Args... args)
 {
     if (open_action != -1) ImGui::SetNextItemOpen(open_action != 0);
-    if (ImGui::TreeNode(n, fmt, args...))
-    {
-        if (align_label_with_current_x_position)
-            ImGui::Unindent(ImGui::GetTreeNodeToLabelSpacing());
+    if (!ImGui::TreeNode(n, fmt, args...)) return false;
 
-        nodeRect = { ImGui::GetItemRectMin(), ImGui::GetItemRectMax() };
+    if (align_label_with_current_x_position)
+        ImGui::Unindent(ImGui::GetTreeNodeToLabelSpacing());
 
-        ImDrawList* drawList = ImGui::GetWindowDrawList();
+    nodeRect = { ImGui::GetItemRectMin(), ImGui::GetItemRectMax() };
 
-        ImVec2 verticalLineStart = ImGui::GetCursorScreenPos();
-        verticalLineStart.x += SmallOffsetX; //to nicely line up with the arrow symbol
-        ImVec2 verticalLineEnd = verticalLineStart;
+    ImVec2 verticalLineStart = ImGui::GetCursorScreenPos();
+    verticalLineStart.x += SmallOffsetX; //to nicely line up with the arrow symbol
+    openNodes.push_back({ key, verticalLineStart });
+    return true;
+}
 
-        visitCallback();
-        const float midpoint = (nodeRect.min.y + nodeRect.max.y) / 2.0f;
+void ASTVisualizer::EndNode(const NodeIndex key)
+{
+    if (openNodes.empty() || openNodes.back().key != key) return;
 
-        drawList->AddLine(ImVec2(verticalLineStart.x, midpoint), ImVec2(verticalLineStart.x + HorizontalTreeLineSize, midpoint), TreeLineColor);
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
 
-        verticalLineEnd.y = midpoint;
+    // nodeRect is now the last node rendered under this one
+    const ImVec2 verticalLineStart = openNodes.back().verticalLineStart;
+    openNodes.pop_back();
+    const float midpoint = (nodeRect.min.y + nodeRect.max.y) / 2.0f;
 
-        if (align_label_with_current_x_position)
-            ImGui::Indent(ImGui::GetTreeNodeToLabelSpacing());
-        ImGui::TreePop();
+    drawList->AddLine(ImVec2(verticalLineStart.x, midpoint), ImVec2(verticalLineStart.x + HorizontalTreeLineSize, midpoint), TreeLineColor);
 
-        drawList->AddLine(verticalLineStart, verticalLineEnd, TreeLineColor);
-    }
-    return nodeRect;
+    ImVec2 verticalLineEnd = verticalLineStart;
+    verticalLineEnd.y = midpoint;
 
+    if (align_label_with_current_x_position)
+        ImGui::Indent(ImGui::GetTreeNodeToLabelSpacing());
+    ImGui::TreePop();
 
-    // NO LINES
-    /*if (open_action != -1) ImGui::SetNextItemOpen(open_action != 0);
-    if (ImGui::TreeNode(n, fmt, args...))
-    {
-        if (align_label_with_current_x_position)
-            ImGui::Unindent(ImGui::GetTreeNodeToLabelSpacing());
-        visitCallback();
-        if (align_label_with_current_x_position)
-            ImGui::Indent(ImGui::GetTreeNodeToLabelSpacing());
-        ImGui::TreePop();
-    }*/
+    drawList->AddLine(verticalLineStart, verticalLineEnd, TreeLineColor);
 }
 
-void ASTVisualizer::Visit(ASTNode& n)       { assert(("ASTVisualizer visited base ASTNode class?!"      , false)); }
-void ASTVisualizer::Visit(UnaryASTNode& n)  { assert(("ASTVisualizer visited base UnaryASTNode class?!" , false)); }
-void ASTVisualizer::Visit(BinaryASTNode& n) { assert(("ASTVisualizer visited base BinaryASTNode class?!", false)); }
 
 void ASTVisualizer::Visit(IntegerNode& n)
 {
@@ -93,10 +97,13 @@ void ASTVisualizer::Visit(IntegerNode& n)
     //drawList->AddLine(verticalLineStart, verticalLineEnd, TreeLineColor);
 }
 
-void ASTVisualizer::Visit(IdentifierNode& n)
+void ASTVisualizer::Visit(IdentifierNode& n) { RenderIdentifier(n, TokenID::IDENTIFIER); }
+
+void ASTVisualizer::RenderIdentifier(const IdentifierNode& n, const TokenID type)
 {
     ImGuiTreeNodeFlags node_flags = base_flags | ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen | ImGuiTreeNodeFlags_Bullet;
-    ImGui::TreeNodeEx((void*)(intptr_t)&n, node_flags, "%s:%s", n.token.str.c_str(), magic_enum::enum_name(n.token.type).data());
+    const std::string_view name = (*tokens)[n.token].str;
+    ImGui::TreeNodeEx((void*)(intptr_t)&n, node_flags, "%.*s:%s", static_cast<int>(name.size()), name.data(), magic_enum::enum_name(type).data());
     nodeRect = { ImGui::GetItemRectMin(), ImGui::GetItemRectMax() };
 
     //ImDrawList* drawList = ImGui::GetWindowDrawList();
@@ -114,103 +121,91 @@ void ASTVisualizer::Visit(IdentifierNode& n)
 
 void ASTVisualizer::Visit(UnaryOperationNode& n)
 {
-    nodeRect = RenderNode( [&]() { n.expr->Accept(*this); }, (void*)(intptr_t)&n, "UNARY OP '%s'", n.op.str.c_str());
+    const std::string_view op = (*tokens)[n.op].str;
+    descend = BeginNode(n.index, (void*)(intptr_t)&n, "UNARY OP '%.*s'", static_cast<int>(op.size()), op.data());
 }
 
 void ASTVisualizer::Visit(BinaryOperationNode& n)
 {
-    nodeRect = RenderNode( [&]() {
-        n.left->Accept(*this); 
-        n.right->Accept(*this); },
-        (void*)(intptr_t)&n, "BINARY OP '%s'", n.op.str.c_str());
+    const std::string_view op = (*tokens)[n.op].str;
+    descend = BeginNode(n.index, (void*)(intptr_t)&n, "BINARY OP '%.*s'", static_cast<int>(op.size()), op.data());
 }
 
 void ASTVisualizer::Visit(ConditionNode& n)
 {
-    nodeRect = RenderNode( [&]() {
-        n.left->Accept(*this); 
-        n.right->Accept(*this); },
-        (void*)(intptr_t)&n, "CONDITION '%s'", n.op.str.c_str());
+    const std::string_view op = (*tokens)[n.op].str;
+    descend = BeginNode(n.index, (void*)(intptr_t)&n, "CONDITION '%.*s'", static_cast<int>(op.size()), op.data());
 }
 
-void ASTVisualizer::Visit(IfNode& n)
-{
-    nodeRect = RenderNode( [&]() {
-        n.condition->Accept(*this); 
-        if (n.body) 
-            n.body->Accept(*this); },
-        (void*)(intptr_t)&n, "%s", n.type.c_str());
-}
+void ASTVisualizer::Visit(IfNode& n)          { descend = BeginNode(n.index, (void*)(intptr_t)&n, "%s", n.elseIf ? "ELSEIF" : "IF"); }
+void ASTVisualizer::Visit(IfStatementNode& n) { descend = BeginNode(n.index, (void*)(intptr_t)&n, "IF_STATEMENT"); }
 
-void ASTVisualizer::Visit(IfStatementNode& n)
-{
-    nodeRect = RenderNode( [&]() {
-        for (const auto& ifN : n.ifNodes) 
-            ifN->Accept(*this); 
-        if (n.elseBody) 
-            n.elseBody->Accept(*this); },
-        (void*)(intptr_t)&n, "IF_STATEMENT");
-}
+void ASTVisualizer::Visit(WhileNode& n)     { descend = BeginNode(n.index, (void*)(intptr_t)&n, "WHILE"); }
+void ASTVisualizer::Visit(DoWhileNode& n)   { descend = BeginNode(n.index, (void*)(intptr_t)&n, "DO_WHILE"); }
 
-void ASTVisualizer::Visit(IterationNode& n) { assert(("ASTVisualizer visited base IterationNode class?!", false)); }
-void ASTVisualizer::Visit(WhileNode& n)
-{
-    nodeRect = RenderNode( [&]() {
-        n.condition->Accept(*this); 
-        if (n.body)  
-            n.body->Accept(*this); },
-        (void*)(intptr_t)&n, "WHILE");
-}
-
-void ASTVisualizer::Visit(DoWhileNode& n)
-{
-    nodeRect = RenderNode( [&]() {
-        n.condition->Accept(*this); 
-        if (n.body) 
-            n.body->Accept(*this); },
-        (void*)(intptr_t)&n, "DO_WHILE");
-}
-
-void ASTVisualizer::Visit(CompoundStatementNode& n)
-{
-    nodeRect = RenderNode( [&]() {
-        for (const auto& statement : n.statements) 
-            statement->Accept(*this); },
-        (void*)(intptr_t)&n, "COMPOUND");
-}
-
-void ASTVisualizer::Visit(StatementBlockNode& n)
-{
-    nodeRect = RenderNode( [&]() {
-        for (const auto& statement : n.statements) 
-            statement->Accept(*this); },
-        (void*)(intptr_t)&n, "STATEMENT_BLOCK");
-}
+void ASTVisualizer::Visit(CompoundStatementNode& n) { descend = BeginNode(n.index, (void*)(intptr_t)&n, "COMPOUND"); }
+void ASTVisualizer::Visit(StatementBlockNode& n)    { descend = BeginNode(n.index, (void*)(intptr_t)&n, "STATEMENT_BLOCK"); }
 
 void ASTVisualizer::Visit(DeclareStatementNode& n)
 {
-    nodeRect = RenderNode( [&]() { n.identifier->Accept(*this); }, (void*)(intptr_t)&n, "DECLARE");
+    // The identifier being declared has the type specifier's type, so it is rendered here rather than walked into
+    if (BeginNode(n.index, (void*)(intptr_t)&n, "DECLARE")) RenderIdentifier(*n.identifier, tokens->GetType(n.type));
+    descend = false;
 }
 
 void ASTVisualizer::Visit(DeclareAssignNode& n)
 {
-    nodeRect = RenderNode( [&]() {
-        n.left->Accept(*this); 
-        n.right->Accept(*this); },
-        (void*)(intptr_t)&n, "DECLARE_ASSIGN '%s'", n.op.str.c_str());
+    const std::string_view op = (*tokens)[n.op].str;
+    descend = BeginNode(n.index, (void*)(intptr_t)&n, "DECLARE_ASSIGN '%.*s'", static_cast<int>(op.size()), op.data());
 }
 
 void ASTVisualizer::Visit(AssignStatementNode& n)
 {
-    nodeRect = RenderNode( [&]() {
-        n.left->Accept(*this); 
-        n.right->Accept(*this); },
-        (void*)(intptr_t)&n, "ASSIGN '%s'", n.op.str.c_str());
+    const std::string_view op = (*tokens)[n.op].str;
+    descend = BeginNode(n.index, (void*)(intptr_t)&n, "ASSIGN '%.*s'", static_cast<int>(op.size()), op.data());
 }
 
-void ASTVisualizer::Visit(ReturnStatementNode& n)
+void ASTVisualizer::Visit(ReturnStatementNode& n) { descend = BeginNode(n.index, (void*)(intptr_t)&n, "RETURN"); }
+
+void ASTVisualizer::Visit(EmptyStatementNode& n) {}
+
+bool ASTVisualizer::RenderFlatNode(const NodeIndex i, const NodeIndex parent)
 {
-    nodeRect = RenderNode( [&]() { n.expr->Accept(*this); }, (void*)(intptr_t)&n, "RETURN");
-}
+    const FlatNode& n = (*flat)[i];
+    // Node ids only need to be unique, the index is as good as the tree's node addresses
+    void* id = (void*)(intptr_t)(i + 1);
+    const std::string_view tok = (*tokens)[n.token].str;
+    const int tokLen = static_cast<int>(tok.size());
+    const ImGuiTreeNodeFlags leafFlags = base_flags | ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen | ImGuiTreeNodeFlags_Bullet;
 
-void ASTVisualizer::Visit(EmptyStatementNode& n) {}
\ No newline at end of file
+    switch (n.kind)
+    {
+    case NodeKind::Integer:
+        ImGui::TreeNodeEx(id, leafFlags, "INT_LITERAL:%d", flat->GetValue(i));
+        nodeRect = { ImGui::GetItemRectMin(), ImGui::GetItemRectMax() };
+        return false;
+    case NodeKind::Identifier:
+    {
+        // The identifier being declared has the type specifier's type
+        const TokenID type = parent != FlatAST::none && (*flat)[parent].kind == NodeKind::DeclareStatement ? tokens->GetType((*flat)[parent].token) : TokenID::IDENTIFIER;
+        ImGui::TreeNodeEx(id, leafFlags, "%.*s:%s", tokLen, tok.data(), magic_enum::enum_name(type).data());
+        nodeRect = { ImGui::GetItemRectMin(), ImGui::GetItemRectMax() };
+        return false;
+    }
+    case NodeKind::UnaryOperation:    return BeginNode(i, id, "UNARY OP '%.*s'",       tokLen, tok.data());
+    case NodeKind::BinaryOperation:   return BeginNode(i, id, "BINARY OP '%.*s'",      tokLen, tok.data());
+    case NodeKind::Condition:         return BeginNode(i, id, "CONDITION '%.*s'",      tokLen, tok.data());
+    case NodeKind::DeclareAssign:     return BeginNode(i, id, "DECLARE_ASSIGN '%.*s'", tokLen, tok.data());
+    case NodeKind::AssignStatement:   return BeginNode(i, id, "ASSIGN '%.*s'",         tokLen, tok.data());
+    case NodeKind::If:                return BeginNode(i, id, "%s", (*flat)[parent].firstChild == i ? "IF" : "ELSEIF");
+    case NodeKind::IfStatement:       return BeginNode(i, id, "IF_STATEMENT");
+    case NodeKind::While:             return BeginNode(i, id, "WHILE");
+    case NodeKind::DoWhile:           return BeginNode(i, id, "DO_WHILE");
+    case NodeKind::CompoundStatement: return BeginNode(i, id, "COMPOUND");
+    case NodeKind::StatementBlock:    return BeginNode(i, id, "STATEMENT_BLOCK");
+    case NodeKind::DeclareStatement:  return BeginNode(i, id, "DECLARE");
+    case NodeKind::ReturnStatement:   return BeginNode(i, id, "RETURN");
+    case NodeKind::EmptyStatement:    return false;
+    }
+    return false;
+}
\ No newline at end of file
@@ -1,11 +1,13 @@
 #pragma once
 #include <imgui.h>
 #include <functional>
+#include <vector>
 
+#include "ASTWalker.h"
 #include "Visitor.h"
 #include "../Util/ModuleManager.h"
 
-class ASTVisualizer : public ASTNodeVisitor, public IObserver<ASTNode>
+class ASTVisualizer : public IObserver<SyntaxTree>
 {
 private:
     ImGuiTreeNodeFlags base_flags = ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_OpenOnDoubleClick | ImGuiTreeNodeFlags_SpanAvailWidth;
@@ -13,6 +15,8 @@ private:
     int open_action = -1;
 
     ASTNode* root = nullptr;
+    const FlatAST* flat = nullptr;
+    const TokenStream* tokens = nullptr;
 
     std::function<void()> renderExtras;
 
@@ -22,38 +26,49 @@ private:
         ImVec2 max;
     } nodeRect;
 
+    ASTWalker walker;
+    // Tree nodes rendered open whose children are being walked, innermost last
+    struct OpenNode
+    {
+        NodeIndex key;
+        ImVec2 verticalLineStart;
+    };
+    std::vector<OpenNode> openNodes;
+    bool descend = true;  // Whether the node just visited was rendered open, with children to walk
+
     const ImColor TreeLineColor = ImColor(128, 128, 128, 255);
     const float SmallOffsetX = -11.0f;
     const float HorizontalTreeLineSize = 8.0f;
 
+    // Renders a node that has children, returns whether it is open. Every node opened has to be ended with its key
     template<class ...Args>
-    ImRect RenderNode(std::function<void()> visitCallback, void* n, const char* fmt, Args...);
+    bool BeginNode(const NodeIndex key, void* n, const char* fmt, Args...);
+    void EndNode(const NodeIndex key);  // Nothing unless key is the innermost node open
+    void RenderIdentifier(const IdentifierNode& n, const TokenID type);
+    // Renders node i of the FlatAST, returns whether its children are to be rendered. parent is needed for the few labels that depend on it
+    bool RenderFlatNode(const NodeIndex i, const NodeIndex parent);
 public:
     void SetExtrasToRender(std::function<void()> extras) { renderExtras = extras; }
     void RenderAST();
 
-    // Inherited via ASTNodeVisitor
-    void Visit(ASTNode& n)               override;
-    void Visit(UnaryASTNode& n)          override;
-    void Visit(BinaryASTNode& n)         override;
-    void Visit(IntegerNode& n)           override;
-    void Visit(IdentifierNode& n)        override;
-    void Visit(UnaryOperationNode& n)    override;
-    void Visit(BinaryOperationNode& n)   override;
-    void Visit(ConditionNode& n)         override;
-    void Visit(IfNode& n)                override;
-    void Visit(IfStatementNode& n)       override;
-    void Visit(IterationNode& n)         override;
-    void Visit(WhileNode& n)             override;
-    void Visit(DoWhileNode& n)           override;
-    void Visit(StatementBlockNode& n)    override;
-    void Visit(CompoundStatementNode& n) override;
-    void Visit(DeclareStatementNode& n)  override;
-    void Visit(DeclareAssignNode& n)     override;
-    void Visit(AssignStatementNode& n)   override;
-    void Visit(ReturnStatementNode& n)   override;
-    void Visit(EmptyStatementNode& n)    override;
+    // Visited through Dispatch
+    void Visit(IntegerNode& n);
+    void Visit(IdentifierNode& n);
+    void Visit(UnaryOperationNode& n);
+    void Visit(BinaryOperationNode& n);
+    void Visit(ConditionNode& n);
+    void Visit(IfNode& n);
+    void Visit(IfStatementNode& n);
+    void Visit(WhileNode& n);
+    void Visit(DoWhileNode& n);
+    void Visit(StatementBlockNode& n);
+    void Visit(CompoundStatementNode& n);
+    void Visit(DeclareStatementNode& n);
+    void Visit(DeclareAssignNode& n);
+    void Visit(AssignStatementNode& n);
+    void Visit(ReturnStatementNode& n);
+    void Visit(EmptyStatementNode& n);
 
     // Inherited via IObserver
-    virtual void Update(ASTNode* n) override { root = n; }
+    virtual void Update(SyntaxTree* ast) override;
 };
\ No newline at end of file
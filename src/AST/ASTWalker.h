@@ -0,0 +1,67 @@
+#pragma once
+#include <vector>
+
+#include "AbstractSyntaxTree.h"
+
+// Depth-first traversal that keeps its own stack rather than recursing, so walking a tree takes the same
+// call stack however deeply it nests. enter(node, parent) is called on the way down (pre-order) and returns
+// whether to walk the node's children, exit(node, parent) on the way back up (post-order) once they are done,
+// for every node that was entered. FlatASTs are walked the same way, with nodes given by index
+// (the root's parent being FlatAST::none). The stacks are kept between walks to reuse their memory.
+class ASTWalker
+{
+private:
+    template<typename Node>
+    struct Step
+    {
+        Node node;
+        Node parent;
+        bool exiting;
+    };
+
+    std::vector<Step<ASTNode*>> steps;
+    std::vector<Step<NodeIndex>> flatSteps;
+    std::vector<ASTNode*> children;
+    std::vector<NodeIndex> flatChildren;
+public:
+    template<typename Enter, typename Exit>
+    void Walk(ASTNode& root, Enter&& enter, Exit&& exit)
+    {
+        steps.clear();  // A callback may have thrown out of the last walk
+        steps.push_back({ &root, nullptr, false });
+        while (!steps.empty())
+        {
+            const Step<ASTNode*> step = steps.back();
+            steps.pop_back();
+            if (step.exiting) { exit(*step.node, step.parent); continue; }
+
+            steps.push_back({ step.node, step.parent, true });
+            if (!enter(*step.node, step.parent)) continue;
+
+            // Pushed last to first so they come off the stack in order
+            children.clear();
+            step.node->AppendChildren(children);
+            for (auto child = children.rbegin(); child != children.rend(); ++child) steps.push_back({ *child, step.node, false });
+        }
+    }
+
+    template<typename Enter, typename Exit>
+    void Walk(const FlatAST& flat, const NodeIndex root, Enter&& enter, Exit&& exit)
+    {
+        flatSteps.clear();
+        flatSteps.push_back({ root, FlatAST::none, false });
+        while (!flatSteps.empty())
+        {
+            const Step<NodeIndex> step = flatSteps.back();
+            flatSteps.pop_back();
+            if (step.exiting) { exit(step.node, step.parent); continue; }
+
+            flatSteps.push_back({ step.node, step.parent, true });
+            if (!enter(step.node, step.parent)) continue;
+
+            flatChildren.clear();
+            for (NodeIndex child = flat[step.node].firstChild; child != FlatAST::none; child = flat[child].nextSibling) flatChildren.push_back(child);
+            for (auto child = flatChildren.rbegin(); child != flatChildren.rend(); ++child) flatSteps.push_back({ *child, step.node, false });
+        }
+    }
+};
\ No newline at end of file
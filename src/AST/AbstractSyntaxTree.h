@@ -1,67 +1,65 @@
 #pragma once
 #include <memory>
+#include <vector>
 
+#include "ASTArena.h"
+#include "FlatAST.h"
 #include "../AST/Visitor.h"
-#include "../Lexer/Token.h"
-
-// Template Alias for node ptrs
-template<typename T>
-using UnqPtr = std::unique_ptr<T>;
+#include "../Lexer/TokenStream.h"
 
 // Base Node class
 class ASTNode
 {
 public:
-    std::string parentID;
+    // Allocation order in the tree's arena, dense from 0. Passes key their side tables on it, and it is the node's
+    // ID wherever one is shown: given while parsing, so the same source always numbers its nodes the same way
+    NodeIndex index = 0;
+    // Concrete class of the node, what Dispatch switches on
+    const NodeKind kind;
 public:
-    ASTNode() = default;
+    ASTNode(const NodeKind k) noexcept : kind(k) {}
     ASTNode(const ASTNode&) = default;
     virtual ~ASTNode() = default;
     ASTNode(ASTNode&&) = default;
-    ASTNode& operator=(const ASTNode&) = default;
-    ASTNode& operator=(ASTNode&&) = default;
 
-    // To allow a class implementing the visitor pattern to visit this node
+    // To allow a class implementing the visitor pattern to visit this node through virtual calls (see Dispatch for the static way)
     virtual void Accept(ASTNodeVisitor& v) = 0;
-    // Sets each child's parentID to the current node's id (for AST visualization)
-    virtual void SetChildrenPrintID(const std::string& pID) = 0;
+    // Appends the node's children in order, for traversals that keep their own stack (see ASTWalker)
+    virtual void AppendChildren(std::vector<ASTNode*>& children) const { /* No children */ }
 };
 
 // Abstract Syntax Tree Node with one branch or leaf
 class UnaryASTNode : public ASTNode
 {
 public:
-    UnqPtr<ASTNode> expr;
+    ASTNode* expr;
 public:
-    UnaryASTNode(UnqPtr<ASTNode> n) noexcept : expr(std::move(n)) {}
+    UnaryASTNode(const NodeKind k, ASTNode* n) noexcept : ASTNode(k), expr(n) {}
 
-    void Accept(ASTNodeVisitor& v) override { v.Visit(*this); }
-    void SetChildrenPrintID(const std::string& pID) override { expr->parentID = pID; }
+    void AppendChildren(std::vector<ASTNode*>& children) const override { children.push_back(expr); }
 };
 
 class UnaryOperationNode : public UnaryASTNode
 {
 public:
-    Token op;
+    TokenIndex op;
 public:
-    UnaryOperationNode(const Token& t, UnqPtr<ASTNode> n) noexcept : UnaryASTNode(std::move(n)), op(t) {}
+    UnaryOperationNode(const TokenIndex t, ASTNode* n) noexcept : UnaryASTNode(NodeKind::UnaryOperation, n), op(t) {}
 
     void Accept(ASTNodeVisitor& v) override { v.Visit(*this); }
-    void SetChildrenPrintID(const std::string& pID) override { expr->parentID = pID; }
 };
 
 // Abstract Syntax Tree Node with two branches or leaves
 class BinaryASTNode : public ASTNode
 {
 public:
-    UnqPtr<ASTNode> left;
-    UnqPtr<ASTNode> right;
-    Token op;
+    TokenIndex op;  // First, so it packs next to the base's index
+    ASTNode* left;
+    ASTNode* right;
 public:
-    BinaryASTNode(UnqPtr<ASTNode> l, const Token& o, UnqPtr<ASTNode> r) noexcept : left(std::move(l)), op(o), right(std::move(r)) {}
+    BinaryASTNode(const NodeKind k, ASTNode* l, const TokenIndex o, ASTNode* r) noexcept : ASTNode(k), op(o), left(l), right(r) {}
 
-    void Accept(ASTNodeVisitor& v) override { v.Visit(*this); }
-    void SetChildrenPrintID(const std::string& pID) override { left->parentID = pID; right->parentID = pID; }
+    void AppendChildren(std::vector<ASTNode*>& children) const override { children.push_back(left); children.push_back(right); }
 };
 
 // Node representing a number(integer) literal
@@ -70,30 +68,27 @@ class IntegerNode : public ASTNode       // this doesnt have a token anymore - d
 public:
     int value;  // should this just be a string for ease?
 public:
-    IntegerNode(const std::string& val) : value(std::stoi(val)) {}
+    IntegerNode(const int val) : ASTNode(NodeKind::Integer), value(val) {}
 
     void Accept(ASTNodeVisitor& v) override { v.Visit(*this); }
-    void SetChildrenPrintID(const std::string& pID) noexcept override { /* No children */ }
 };
 
 // Node representing an identifier
 class IdentifierNode : public ASTNode
 {
 public:
-    Token token;
-    std::string offset;
+    TokenIndex token;
 public:
-    IdentifierNode(const Token& tok) : token(tok) {}
+    IdentifierNode(const TokenIndex tok) : ASTNode(NodeKind::Identifier), token(tok) {}
 
     void Accept(ASTNodeVisitor& v) override { v.Visit(*this); }
-    void SetChildrenPrintID(const std::string& pID) noexcept override { /* No children */ }
 };
 
 // Node representing a binary operation
 class BinaryOperationNode : public BinaryASTNode
 {
 public:
-    BinaryOperationNode(UnqPtr<ASTNode> l, const Token& o, UnqPtr<ASTNode> r) noexcept : BinaryASTNode(std::move(l), o, std::move(r)) {}
+    BinaryOperationNode(ASTNode* l, const TokenIndex o, ASTNode* r) noexcept : BinaryASTNode(NodeKind::BinaryOperation, l, o, r) {}
 
     void Accept(ASTNodeVisitor& v) override { v.Visit(*this); }
 };
@@ -101,7 +96,7 @@ public:
 class ConditionNode : public BinaryASTNode
 {
 public:
-    ConditionNode(UnqPtr<ASTNode> l, const Token& o, UnqPtr<ASTNode> r) noexcept : BinaryASTNode(std::move(l), o, std::move(r)) {}
+    ConditionNode(ASTNode* l, const TokenIndex o, ASTNode* r) noexcept : BinaryASTNode(NodeKind::Condition, l, o, r) {}
 
     void Accept(ASTNodeVisitor& v) override { v.Visit(*this); }
 };
@@ -110,54 +105,53 @@ public:
 class IfNode : public ASTNode
 {
 public:
-    UnqPtr<ASTNode> condition;
-    UnqPtr<ASTNode> body;
-    std::string type;  // IF or ELSE_IF used only for visualization
-    std::string parentEndLabel;
+    bool elseIf = false;  // Set for all but the first IfNode of an IfStatementNode
+    ASTNode* condition;
+    ASTNode* body;
 public:
-    IfNode(UnqPtr<ASTNode> b, UnqPtr<ASTNode> cond) noexcept : body(std::move(b)),  condition(std::move(cond)) {}
+    IfNode(ASTNode* b, ASTNode* cond) noexcept : ASTNode(NodeKind::If), condition(cond), body(b) {}
 
     void Accept(ASTNodeVisitor& v) override { v.Visit(*this); }
-    void SetChildrenPrintID(const std::string& pID) override { condition->parentID = pID; body->parentID = pID; }
+    void AppendChildren(std::vector<ASTNode*>& children) const override { children.push_back(condition); if (body) children.push_back(body); }
 };
 
 // Node representing a collection of an IFNode, several ELSE_IF and an ELSE CompoundStatementNode
 class IfStatementNode : public ASTNode
 {
 public:
-    std::vector<UnqPtr<IfNode>> ifNodes;
-    UnqPtr<ASTNode> elseBody;
+    std::vector<IfNode*> ifNodes;
+    ASTNode* elseBody = nullptr;
 public:
+    IfStatementNode() noexcept : ASTNode(NodeKind::IfStatement) {}
 
-    void AddNode(UnqPtr<IfNode> node)
+    void AddNode(IfNode* node)
     {
-        ifNodes.empty() ? node->type = "IF" : node->type = "ELSEIF";
-        ifNodes.push_back(std::move(node));
+        node->elseIf = !ifNodes.empty();
+        ifNodes.push_back(node);
     }
     void Accept(ASTNodeVisitor& v) override { v.Visit(*this); }
-    void SetChildrenPrintID(const std::string& pID) override
+    void AppendChildren(std::vector<ASTNode*>& children) const override
     {
-        for (const auto& ifN : ifNodes) ifN->parentID = pID;
-        if (elseBody) elseBody->parentID = pID;
+        children.insert(children.end(), ifNodes.begin(), ifNodes.end());
+        if (elseBody) children.push_back(elseBody);
     }
 };
 
 class IterationNode : public ASTNode
 {
 public:
-    UnqPtr<ASTNode> condition;
-    UnqPtr<ASTNode> body;
+    ASTNode* condition;
+    ASTNode* body;
 public:
-    IterationNode(UnqPtr<ASTNode> cond, UnqPtr<ASTNode> b) noexcept : condition(std::move(cond)), body(std::move(b)) {}
+    IterationNode(const NodeKind k, ASTNode* cond, ASTNode* b) noexcept : ASTNode(k), condition(cond), body(b) {}
 
-    void Accept(ASTNodeVisitor& v) override { v.Visit(*this); }
-    void SetChildrenPrintID(const std::string& pID) override { condition->parentID = pID; body->parentID = pID; }
+    void AppendChildren(std::vector<ASTNode*>& children) const override { children.push_back(condition); if (body) children.push_back(body); }
 };
 
 class WhileNode : public IterationNode
 {
 public:
-    WhileNode(UnqPtr<ASTNode> cond, UnqPtr<ASTNode> b) noexcept : IterationNode(std::move(cond), std::move(b)) {}
+    WhileNode(ASTNode* cond, ASTNode* b) noexcept : IterationNode(NodeKind::While, cond, b) {}
 
     void Accept(ASTNodeVisitor& v) override { v.Visit(*this); }
 };
@@ -165,7 +159,7 @@ public:
 class DoWhileNode : public IterationNode
 {
 public:
-    DoWhileNode(UnqPtr<ASTNode> cond, UnqPtr<ASTNode> b) noexcept : IterationNode(std::move(cond), std::move(b)) {}
+    DoWhileNode(ASTNode* cond, ASTNode* b) noexcept : IterationNode(NodeKind::DoWhile, cond, b) {}
 
     void Accept(ASTNodeVisitor& v) override { v.Visit(*this); }
 };
@@ -173,36 +167,45 @@ public:
 class CompoundStatementNode : public ASTNode
 {
 public:
-    std::vector<UnqPtr<ASTNode>> statements;
+    std::vector<ASTNode*> statements;
+    // Its curly brackets, an edit between them is reparsed as this list alone
+    TokenIndex open = 0;
+    TokenIndex close = 0;
+protected:
+    CompoundStatementNode(const NodeKind k) noexcept : ASTNode(k) {}
 public:
+    CompoundStatementNode() noexcept : ASTNode(NodeKind::CompoundStatement) {}
+
     void Accept(ASTNodeVisitor& v) override { v.Visit(*this); }
-    void SetChildrenPrintID(const std::string& pID) override { for (const auto& statement : statements) statement->parentID = pID; }
+    void AppendChildren(std::vector<ASTNode*>& children) const override { children.insert(children.end(), statements.begin(), statements.end()); }
 
-    void Push(UnqPtr<ASTNode> statement) { statements.push_back(std::move(statement)); }
+    void Push(ASTNode* statement) { statements.push_back(statement); }
 };
 
 class StatementBlockNode : public CompoundStatementNode
 {
 public:
+    StatementBlockNode() noexcept : CompoundStatementNode(NodeKind::StatementBlock) {}
+
     void Accept(ASTNodeVisitor& v) override { v.Visit(*this); }
 };
 
 class DeclareStatementNode : public ASTNode
 {
 public:
-    UnqPtr<IdentifierNode> identifier;
-    Token type;
+    TokenIndex type;
+    IdentifierNode* identifier;
 public:
-    DeclareStatementNode(UnqPtr<IdentifierNode> ident, const Token& t) noexcept : identifier(std::move(ident)), type(t) { identifier->token.type = t.type; }
+    DeclareStatementNode(IdentifierNode* ident, const TokenIndex t) noexcept : ASTNode(NodeKind::DeclareStatement), type(t), identifier(ident) {}
 
     void Accept(ASTNodeVisitor& v) override { v.Visit(*this); }
-    void SetChildrenPrintID(const std::string& pID) override {identifier->parentID = pID; }
+    void AppendChildren(std::vector<ASTNode*>& children) const override { children.push_back(identifier); }
 };
 
 class DeclareAssignNode : public BinaryASTNode
 {
 public:
-    DeclareAssignNode(UnqPtr<DeclareStatementNode> decl, const Token& o, UnqPtr<ASTNode> expr) noexcept : BinaryASTNode(std::move(decl), o, std::move(expr)) {}
+    DeclareAssignNode(DeclareStatementNode* decl, const TokenIndex o, ASTNode* expr) noexcept : BinaryASTNode(NodeKind::DeclareAssign, decl, o, expr) {}
 
     void Accept(ASTNodeVisitor& v) override { v.Visit(*this); }
 };
@@ -210,7 +213,7 @@ public:
 class AssignStatementNode : public BinaryASTNode
 {
 public:
-    AssignStatementNode(UnqPtr<IdentifierNode> ident, const Token& o, UnqPtr<ASTNode> expr) noexcept : BinaryASTNode(std::move(ident), o, std::move(expr)) {}
+    AssignStatementNode(IdentifierNode* ident, const TokenIndex o, ASTNode* expr) noexcept : BinaryASTNode(NodeKind::AssignStatement, ident, o, expr) {}
 
     void Accept(ASTNodeVisitor& v) override { v.Visit(*this); }
 };
@@ -218,17 +221,62 @@ public:
 class ReturnStatementNode : public UnaryASTNode
 {
 public:
-    ReturnStatementNode(UnqPtr<ASTNode> n) noexcept : UnaryASTNode(std::move(n)) {}
+    ReturnStatementNode(ASTNode* n) noexcept : UnaryASTNode(NodeKind::ReturnStatement, n) {}
 
     void Accept(ASTNodeVisitor& v) override { v.Visit(*this); }
-    void SetChildrenPrintID(const std::string& pID) override { expr->parentID = pID; }
 };
 
 class EmptyStatementNode : public ASTNode
 {
 public:
+    EmptyStatementNode() noexcept : ASTNode(NodeKind::EmptyStatement) {}
+
     void Accept(ASTNodeVisitor& v) override { v.Visit(*this); }
-    void SetChildrenPrintID(const std::string& pID) noexcept override { /* No Children */ }
+};
+
+// Calls the pass's Visit overload for the node's concrete class, switching on its kind rather than
+// going through Accept and a virtual Visit. Pass only needs a (non-virtual) Visit for each concrete class,
+// and whatever they return is returned
+template<typename Pass>
+decltype(auto) Dispatch(Pass& pass, ASTNode& n)
+{
+    switch (n.kind)
+    {
+    case NodeKind::Integer:           return pass.Visit(static_cast<IntegerNode&>(n));
+    case NodeKind::Identifier:        return pass.Visit(static_cast<IdentifierNode&>(n));
+    case NodeKind::UnaryOperation:    return pass.Visit(static_cast<UnaryOperationNode&>(n));
+    case NodeKind::BinaryOperation:   return pass.Visit(static_cast<BinaryOperationNode&>(n));
+    case NodeKind::Condition:         return pass.Visit(static_cast<ConditionNode&>(n));
+    case NodeKind::If:                return pass.Visit(static_cast<IfNode&>(n));
+    case NodeKind::IfStatement:       return pass.Visit(static_cast<IfStatementNode&>(n));
+    case NodeKind::While:             return pass.Visit(static_cast<WhileNode&>(n));
+    case NodeKind::DoWhile:           return pass.Visit(static_cast<DoWhileNode&>(n));
+    case NodeKind::CompoundStatement: return pass.Visit(static_cast<CompoundStatementNode&>(n));
+    case NodeKind::StatementBlock:    return pass.Visit(static_cast<StatementBlockNode&>(n));
+    case NodeKind::DeclareStatement:  return pass.Visit(static_cast<DeclareStatementNode&>(n));
+    case NodeKind::DeclareAssign:     return pass.Visit(static_cast<DeclareAssignNode&>(n));
+    case NodeKind::AssignStatement:   return pass.Visit(static_cast<AssignStatementNode&>(n));
+    case NodeKind::ReturnStatement:   return pass.Visit(static_cast<ReturnStatementNode&>(n));
+    case NodeKind::EmptyStatement:
+    default:                          return pass.Visit(static_cast<EmptyStatementNode&>(n));
+    }
+}
+
+// A parsed program. Nodes refer to their tokens by index, so the tree keeps the
+// token stream it was parsed from alive for as long as the nodes exist.
+// All nodes live in the arena, children only point to each other.
+// When the parser is asked for a flat AST, flat holds the tree instead and root is null
+struct SyntaxTree
+{
+    ASTArena arena;
+    ASTNode* root = nullptr;
+    FlatAST flat;
+    std::shared_ptr<const TokenStream> tokens;
+    // Statement lists the last parse replaced the statements of, or just root when it parsed everything.
+    // Empty if nothing changed or the tree is flat. Everything outside of them is the same nodes as before (their tokens moved by the edit)
+    std::vector<ASTNode*> changed;
+
+    bool empty() const { return !root && flat.empty(); }
 };
 
 /*
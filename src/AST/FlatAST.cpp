@@ -0,0 +1,66 @@
+#include "FlatAST.h"
+#include "ASTWalker.h"
+#include "AbstractSyntaxTree.h"
+
+// Appends each node it enters, linking it up as the last child of the node it was entered from
+class FlatASTBuilder
+{
+private:
+    std::vector<FlatNode>& nodes;
+    std::vector<int32_t>& values;
+
+    // Nodes on the path from the root to the one being added, with the last child each has so far
+    struct Open
+    {
+        NodeIndex index;
+        NodeIndex lastChild;
+    };
+    std::vector<Open> open;
+
+    void Add(const NodeKind kind, const uint32_t token = 0, const int32_t value = 0)
+    {
+        const NodeIndex index = static_cast<NodeIndex>(nodes.size());
+        nodes.push_back({ FlatAST::none, FlatAST::none, token, kind });
+        values.push_back(value);
+        if (!open.empty())
+        {
+            Open& parent = open.back();
+            (parent.lastChild == FlatAST::none ? nodes[parent.index].firstChild : nodes[parent.lastChild].nextSibling) = index;
+            parent.lastChild = index;
+        }
+        open.push_back({ index, FlatAST::none });
+    }
+public:
+    FlatASTBuilder(std::vector<FlatNode>& n, std::vector<int32_t>& v) : nodes(n), values(v) {}
+
+    void Build(ASTNode& root)
+    {
+        ASTWalker walker;
+        walker.Walk(root, [this](ASTNode& n, ASTNode*) { Dispatch(*this, n); return true; }, [this](ASTNode&, ASTNode*) { open.pop_back(); });
+    }
+
+    void Visit(IntegerNode& n)           { Add(NodeKind::Integer, 0, n.value); }
+    void Visit(IdentifierNode& n)        { Add(NodeKind::Identifier, n.token); }
+    void Visit(UnaryOperationNode& n)    { Add(NodeKind::UnaryOperation,   n.op); }
+    void Visit(BinaryOperationNode& n)   { Add(NodeKind::BinaryOperation,  n.op); }
+    void Visit(ConditionNode& n)         { Add(NodeKind::Condition,        n.op); }
+    void Visit(IfNode& n)                { Add(NodeKind::If); }
+    void Visit(IfStatementNode& n)       { Add(NodeKind::IfStatement); }
+    void Visit(WhileNode& n)             { Add(NodeKind::While); }
+    void Visit(DoWhileNode& n)           { Add(NodeKind::DoWhile); }
+    void Visit(DeclareStatementNode& n)  { Add(NodeKind::DeclareStatement, n.type); }
+    void Visit(DeclareAssignNode& n)     { Add(NodeKind::DeclareAssign,    n.op); }
+    void Visit(AssignStatementNode& n)   { Add(NodeKind::AssignStatement,  n.op); }
+    void Visit(ReturnStatementNode& n)   { Add(NodeKind::ReturnStatement); }
+    void Visit(EmptyStatementNode& n)    { Add(NodeKind::EmptyStatement); }
+    void Visit(CompoundStatementNode& n) { Add(NodeKind::CompoundStatement); }
+    void Visit(StatementBlockNode& n)    { Add(NodeKind::StatementBlock); }
+};
+
+void FlatAST::Build(ASTNode& root)
+{
+    Clear();
+    FlatASTBuilder(nodes, values).Build(root);
+    nodes.shrink_to_fit();
+    values.shrink_to_fit();
+}
\ No newline at end of file
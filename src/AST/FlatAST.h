@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "../Lexer/Token.h"
+
+class ASTNode;
+
+// One per concrete ASTNode class
+enum class NodeKind : uint8_t
+{
+    Integer, Identifier, UnaryOperation, BinaryOperation, Condition, If, IfStatement, While, DoWhile,
+    CompoundStatement, StatementBlock, DeclareStatement, DeclareAssign, AssignStatement, ReturnStatement, EmptyStatement
+};
+
+using NodeIndex = uint32_t;
+
+// Children in order, reached from firstChild through each one's nextSibling:
+//   UnaryOperation, ReturnStatement                              expression
+//   BinaryOperation, Condition, DeclareAssign, AssignStatement   left, right (DeclareStatement for DeclareAssign)
+//   If, While, DoWhile                                           condition, body
+//   IfStatement                                                  the IF, any ELSE_IFs, then the else body if there is one
+//   CompoundStatement, StatementBlock                            statements
+//   DeclareStatement                                             identifier
+struct FlatNode
+{
+    NodeIndex firstChild;
+    NodeIndex nextSibling;
+    uint32_t  token;  // Operator, identifier or type specifier. Unused by integers, nodes without a token hold 0
+    NodeKind  kind;
+};
+
+// The AST as a single array of nodes in pre-order: a node's subtree directly follows it, so whole-tree passes
+// walk it front to back, and it is a fraction of the size of the pointer tree it is built from.
+// Root is node 0
+class FlatAST
+{
+public:
+    static constexpr NodeIndex none = UINT32_MAX;
+private:
+    std::vector<FlatNode> nodes;
+    // Side array parallel to nodes, holding the integers' values
+    std::vector<int32_t> values;
+    friend class FlatASTBuilder;
+public:
+    // Replaces the contents with the tree under root
+    void Build(ASTNode& root);
+    void Clear() { nodes.clear(); values.clear(); }
+
+    const FlatNode& operator[](const NodeIndex i) const { return nodes[i]; }
+    size_t size()                                 const { return nodes.size(); }
+    bool empty()                                  const { return nodes.empty(); }
+
+    int32_t GetValue(const NodeIndex i)           const { return values[i]; }
+    NodeIndex GetSecondChild(const NodeIndex i)   const { return nodes[nodes[i].firstChild].nextSibling; }
+
+    double GetBytesPerNode() const { return nodes.empty() ? 0.0 : static_cast<double>(nodes.capacity() * sizeof(FlatNode) + values.capacity() * sizeof(int32_t)) / nodes.size(); }
+};
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include <cassert>
+#include <utility>
 
 // Forward Declarations
 class ASTNode;
@@ -22,18 +23,22 @@ class DeclareAssignNode;
 class AssignStatementNode;
 class ReturnStatementNode;
 class EmptyStatementNode;
+class TokenStream;
+struct SyntaxTree;
 
-// Pure Abstract Class/Interface that all classes that "walk" the AST should inherit from
+template<typename Pass>
+decltype(auto) Dispatch(Pass& pass, ASTNode& n);  // Defined along with the nodes
+
+// Pure Abstract Class/Interface for classes that "walk" the AST through virtual calls
 // Based on the Visitor Pattern
 // Each member of the ASTNode family defines an accept function that accepts the visitor class
 // and calls its visit methods based on the ASTNode class that called it.
+// The passes themselves are visited through Dispatch instead, which switches on the node's kind
+// and calls their Visit overloads directly. This stays for visitors that need virtual dispatch
 class ASTNodeVisitor
 {
 public:
     virtual ~ASTNodeVisitor() = default;
-    virtual void Visit(ASTNode& n) = 0;
-    virtual void Visit(UnaryASTNode& n) = 0;
-    virtual void Visit(BinaryASTNode& n) = 0;
     virtual void Visit(IntegerNode& n) = 0;
     virtual void Visit(IdentifierNode& n) = 0;
     virtual void Visit(UnaryOperationNode& n) = 0;
@@ -41,7 +46,6 @@ public:
     virtual void Visit(ConditionNode& n) = 0;
     virtual void Visit(IfNode& n) = 0;
     virtual void Visit(IfStatementNode& n) = 0;
-    virtual void Visit(IterationNode& n) = 0;
     virtual void Visit(WhileNode& n) = 0;
     virtual void Visit(DoWhileNode& n) = 0;
     virtual void Visit(StatementBlockNode& n) = 0;
@@ -53,32 +57,10 @@ public:
     virtual void Visit(EmptyStatementNode& n) = 0;
 };
 
-// Curiously Recurring Template Pattern - https://www.codeproject.com/Tips/1018315/Visitor-with-the-Return-Value
-template <typename VisitorImpl, typename VisitablePtr, typename ResultType>
-class ValueGetter
-{
-private:
-    ResultType value;
-public:
-    void PlainVisit(VisitablePtr n)
-    {
-        VisitorImpl vis;
-        n->Accept(vis);
-    }
-    static ResultType GetValue(VisitablePtr n)
-    {
-        VisitorImpl vis;
-        n->Accept(vis);
-        return vis.value;
-    }
-    void Return(ResultType val)
-    {
-        value = val;
-    }
-};
-
-// Inheriting Classes:
+// Passes visited through Dispatch:
 // ASTVisualizer
+// ASTPrinterJson
+// FlatASTBuilder
 // SemanticAnalyser
 // Code Generator
 // Interpreter (NOT BEING IMPLEMENTED)
\ No newline at end of file
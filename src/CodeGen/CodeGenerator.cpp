@@ -1,11 +1,13 @@
+#include <chrono>
 #include <map>
 #include <sstream>
+#include <stdexcept>
 
 #include "CodeGenerator.h"
 #include "../AST/AbstractSyntaxTree.h"
+#include "../Semantics/SemanticAnalyzer.h"
 #include "../Util/Logger.h"
 
-std::vector<Quadruples> CodeGenerator::instructions;
 int Temporary::tempCount = 0;
 int Label::labelCount = 0;
 int Label::nextCmpLabel = 0;
@@ -36,7 +38,7 @@ static const std::map<std::string, std::string> asmLookup =
 
 void CodeGenerator::Update()
 {
-    if (!shouldRun || !root || !semSuccess) return;
+    if (!shouldRun || (!root && (!flat || flat->empty())) || !semSuccess) return;
 
     Reset();
 
@@ -50,6 +52,22 @@ void CodeGenerator::Update()
     shouldRun = false;
 }
 
+void CodeGenerator::Update(SyntaxTree* ast)
+{
+    root = ast->root;
+    flat = &ast->flat;
+    tokens = ast->tokens.get();
+    nodeCount = root ? ast->arena.GetNodeCount() : flat->size();
+}
+
+void CodeGenerator::Update(SemanticResult* result)
+{
+    semSuccess = !result->failed;
+    frameSlots = result->frameSlots;
+    frameSize  = result->frameSize;
+    expressions = result->expressions;
+}
+
 void CodeGenerator::Reset()
 {
     instructions.clear();
@@ -59,9 +77,32 @@ void CodeGenerator::Reset()
     x86.clear();
 }
 
+void CodeGenerator::Benchmark(const size_t runs)
+{
+    if ((!root && (!flat || flat->empty())) || !semSuccess || !nodeCount) { Logger::Warn("No analysed AST to benchmark code generation on\n"); return; }
+
+    const auto generate = [this]() {
+        instructions.clear();
+        GenerateCode();
+    };
+    generate();  // Warm up
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < runs; ++i) generate();
+    const std::chrono::duration<double, std::nano> generation = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < runs * nodeCount; ++i) CodeGenerator throwaway;
+    const std::chrono::duration<double, std::nano> construction = std::chrono::steady_clock::now() - start;
+
+    const double perRun = static_cast<double>(runs * nodeCount);
+    Logger::Info("Code generation: {} nodes, {} runs, {:.1f} ns per node. A generator constructed per node would add {:.1f} ns\n",
+        nodeCount, runs, generation.count() / perRun, construction.count() / perRun);
+}
+
 void CodeGenerator::GenerateTAC()
 {
-    PlainVisit(root);  // Start Traversing the AST
+    GenerateCode();  // Start Traversing the AST
 
     if (instructions.empty()) { Logger::Info("No Intermediate Code Generated.\n"); return; }
     else Logger::Info("Intermediate Language Representation Generated\n");
@@ -98,9 +139,11 @@ void CodeGenerator::GenerateAssembly()
     else Logger::Info("'Assembly' Generated\n");
 
     x86 << "main:\n";
+    x86 << "\tpush ebp\n\tmov ebp, esp\n";
+    if (frameSize) x86 << "\tsub esp, " << frameSize << '\n';
     for (auto& [op, src1, src2, dest] : instructions)
     {
-        const auto destination = asmLookup.find(dest->name) != asmLookup.end() ? asmLookup.at(dest->name) : dest->address;
+        const auto destination = Location(*dest);
         if (op->type == CmdType::GOTO)       x86 << asmLookup.at("Goto") << destination << '\n';
         else if (op->type == CmdType::LABEL) x86 << destination << ":\n";
         else if (op->type == CmdType::IF);   // We processed condition(s) for this control flow, no need to do anything
@@ -109,14 +152,19 @@ void CodeGenerator::GenerateAssembly()
             x86 << "\tmov eax, " << destination << '\n'; // EAX will always have the return value
             x86 << asmLookup.at("Goto") << "_END\n";     // Jump to the end label, since return might have been nested somewhere
         }
-        else if (const auto operand1 = asmLookup.find(src1->name) != asmLookup.end() ? asmLookup.at(src1->name) : src1->address; src1 && !src2)
+        else if (const auto operand1 = Location(*src1); src1 && !src2)
         {
             x86 << "\tmov " << destination << ", " << operand1 << '\n';
-            if (op->type == CmdType::UNARY) x86 << "\tneg " << destination << '\n';
+            if (op->type == CmdType::UNARY)
+            {
+                if (op->value == "~") x86 << "\tnot " << destination << '\n';
+                else if (op->value == "!" || op->value == "++" || op->value == "--") throw std::invalid_argument(op->value);
+                else x86 << "\tneg " << destination << '\n';
+            }
         }
         else if (src2)
         {
-            const auto operand2 = asmLookup.find(src2->name) != asmLookup.end() ? asmLookup.at(src2->name) : src2->address;
+            const auto operand2 = Location(*src2);
             if (op->type == CmdType::RELAT)
             {
                 if (operand1 != destination) x86 << "\tmov " << destination << ", " << operand1 << '\n';
@@ -137,6 +185,15 @@ void CodeGenerator::GenerateAssembly()
         }
     }
     x86 << "_END:\n"; // Final label that all return statements jump to - will need to change when functions are introduced
+    x86 << "\tmov esp, ebp\n\tpop ebp\n\tret\n";
+}
+
+const std::string CodeGenerator::Location(const Operand& o) const
+{
+    if (const auto reg = asmLookup.find(o.name); reg != asmLookup.end()) return reg->second;
+    // Only ints so far, every slot is a DWORD
+    if (o.frameOffset) return "DWORD [ebp" + std::to_string(o.frameOffset) + "]";
+    return o.address;
 }
 
 const std::string CodeGenerator::ReverseOp(const std::string& op) const
@@ -150,125 +207,307 @@ const std::string CodeGenerator::ReverseOp(const std::string& op) const
     else                 return op;
 }
 
-void CodeGenerator::Visit(ASTNode& n)        { assert(("Code Generator visited base ASTNode class?!"      , false)); }
-void CodeGenerator::Visit(UnaryASTNode& n)   { assert(("Code Generator visited base UnaryASTNode class?!" , false)); }
-void CodeGenerator::Visit(BinaryASTNode& n)  { assert(("Code Generator visited base BinaryASTNode class?!", false)); }
 
-// Integer and Identifier Leaf Nodes. A throwaway Quadruple is returned that effectively passes back their value or name
-void CodeGenerator::Visit(IntegerNode& n)    { Return({ std::nullopt, std::nullopt, std::nullopt, Operand{CmdType::NONE, std::to_string(n.value), std::to_string(n.value)} }); }
-void CodeGenerator::Visit(IdentifierNode& n) { Return({ std::nullopt, std::nullopt,  std::nullopt, Operand{CmdType::NONE, n.token.str, "DWORD [ebp" + n.offset + "]"} }); }
+void CodeGenerator::GenerateCode()
+{
+    values.clear();  // Generation may have thrown out of the last run
+    labels.clear();
+    if (root) walker.Walk(*root, [this](ASTNode& n, ASTNode* parent) { return Enter(n, parent); }, [this](ASTNode& n, ASTNode* parent) { Exit(n, parent); });
+    else      walker.Walk(*flat, 0, [this](const NodeIndex i, const NodeIndex parent) { return Enter(i, parent); }, [this](const NodeIndex i, const NodeIndex parent) { Generate(i, parent); });
+}
 
-void CodeGenerator::Visit(UnaryOperationNode& n)
+void CodeGenerator::EnterChild(const NodeKind parent, const bool first)
 {
-    instructions.push_back({ Command{n.op.str, CmdType::UNARY }, fetch_instr(n.expr.get()).dest, std::nullopt, Temporary::NewTemporary() });
-    Return(instructions.back());
+    switch (parent)
+    {
+    case NodeKind::BinaryOperation:
+    case NodeKind::Condition:
+#ifdef OPTIMIZE_TEMPS
+        // The left operand's temporary is done with, the result can take it before the right operand is generated
+        if (!first) { fetch_value(values.back()); values.push_back({ std::nullopt, std::nullopt, std::nullopt, Temporary::NewTemporary() }); }
+#endif // OPTIMIZE_TEMPS
+        return;
+    // The body comes after the condition, which jumps out of the if (to the next else if, or the else) or the loop
+    case NodeKind::If:
+    case NodeKind::While:
+        if (!first) EmitJump("IfFalse", labels.back());
+        return;
+    default:
+        return;
+    }
+}
+
+bool CodeGenerator::Enter(const NodeKind kind, const NodeIndex i)
+{
+    switch (kind)
+    {
+    // A folded expression is generated as its value, its operands have no code
+    case NodeKind::UnaryOperation:
+    case NodeKind::BinaryOperation:
+        return !(*expressions)[i].constant;
+    // The identifier is given its slot by the semantic analyzer, there is no code for it
+    case NodeKind::DeclareStatement:
+        return false;
+    // Label for the end of all the if-elseif-else contained, then the one an if or else-if jumps to if its condition is false
+    case NodeKind::IfStatement:
+    case NodeKind::If:
+        labels.push_back(Label::NewLabel());
+        return true;
+    case NodeKind::While:
+        labels.push_back(Label::NewLabel());
+        EmitLabel(labels.back());
+        labels.push_back(Label::NewLabel());
+        return true;
+    case NodeKind::DoWhile:
+        labels.push_back(Label::NewLabel());
+        EmitLabel(labels.back());
+        return true;
+    default:
+        return true;
+    }
 }
 
-void CodeGenerator::ProcessBinOp(const BinaryASTNode& n, CmdType type)
+bool CodeGenerator::Enter(ASTNode& n, ASTNode* parent)
 {
+    if (parent)
+    {
+        // Generated once the body is done, see Visit(DoWhileNode&)
+        if (parent->kind == NodeKind::DoWhile && static_cast<DoWhileNode*>(parent)->condition == &n) return false;
+        const ASTNode* first = parent->kind == NodeKind::If ? static_cast<IfNode*>(parent)->condition
+                            : parent->kind == NodeKind::While ? static_cast<WhileNode*>(parent)->condition
+                            : parent->kind == NodeKind::BinaryOperation || parent->kind == NodeKind::Condition ? static_cast<BinaryASTNode*>(parent)->left
+                            : nullptr;
+        EnterChild(parent->kind, first == &n);
+    }
+    return Enter(n.kind, n.index);
+}
+
+bool CodeGenerator::Enter(const NodeIndex i, const NodeIndex parent)
+{
+    if (parent != FlatAST::none)
+    {
+        if ((*flat)[parent].kind == NodeKind::DoWhile && (*flat)[parent].firstChild == i) return false;
+        EnterChild((*flat)[parent].kind, (*flat)[parent].firstChild == i);
+    }
+    return Enter((*flat)[i].kind, i);
+}
+
+void CodeGenerator::Exit(ASTNode& n, ASTNode* parent)
+{
+    if (parent && parent->kind == NodeKind::DoWhile && static_cast<DoWhileNode*>(parent)->condition == &n) return;
+    Dispatch(*this, n);
+}
+
+void CodeGenerator::EmitUnary(const std::string_view op)
+{
+    const auto operand = fetch_value(values.back()).dest;
+    values.pop_back();
+    instructions.push_back({ Command{ std::string(op), CmdType::UNARY }, operand, std::nullopt, Temporary::NewTemporary() });
+    values.push_back(instructions.back());
+}
+
+void CodeGenerator::EmitBinOp(const std::string_view op, const CmdType type)
+{
+    const auto src2 = fetch_value(values.back()).dest;
+    values.pop_back();
 #ifdef OPTIMIZE_TEMPS
-    const auto src1 = fetch_instr(n.left.get()).dest;
-    const auto dest = Temporary::NewTemporary();
-    const auto src2 = fetch_instr(n.right.get()).dest;
-    instructions.push_back({ Command{n.op.str, type }, src1, src2, dest });
+    const auto dest = values.back().dest;
+    values.pop_back();
 #else
-    instructions.push_back({ Command{n.op.first, type }, fetch_instr(n.left.get()).dest, fetch_instr(n.right.get()).dest, Temporary::NewTemporary() });
+    const auto dest = Temporary::NewTemporary();
 #endif // OPTIMIZE_TEMPS
-    Return(instructions.back());
+    const auto src1 = values.back().dest;
+    values.pop_back();
+    instructions.push_back({ Command{ std::string(op), type }, src1, src2, dest });
+    values.push_back(instructions.back());
+}
+
+void CodeGenerator::EmitJump(const char* jump, const Operand& label)
+{
+    const auto condition = fetch_value(values.back()).dest;
+    values.pop_back();
+    instructions.push_back({ Command{ jump, CmdType::IF }, condition, std::nullopt, label });
+}
+
+void CodeGenerator::EmitLabel(const Operand& label) { instructions.push_back({ Command{ "Label", CmdType::LABEL }, std::nullopt, std::nullopt, label }); }
+
+// Integer and Identifier Leaf Nodes, they pass their value or name on to their parent
+void CodeGenerator::Visit(IntegerNode& n)    { values.push_back({ std::nullopt, std::nullopt, std::nullopt, Operand{CmdType::NONE, std::to_string(n.value), std::to_string(n.value)} }); }
+void CodeGenerator::Visit(IdentifierNode& n) { values.push_back({ std::nullopt, std::nullopt, std::nullopt, Variable((*tokens)[n.token].str, n.index) }); }
+
+Operand CodeGenerator::Variable(const std::string_view name, const NodeIndex i)
+{
+    // Offset 0 is no variable's, the identifier was never resolved
+    return Operand{ CmdType::NONE, std::string(name), "DWORD [ebp]", (*frameSlots)[i] };
+}
+
+std::optional<Operand> CodeGenerator::Folded(const NodeIndex i) const
+{
+    const ExpressionInfo& e = (*expressions)[i];
+    if (!e.constant) return std::nullopt;
+    const std::string value = e.type == ValueType::FLOAT ? std::to_string(e.value.f) : std::to_string(e.value.i);
+    return Operand{ CmdType::NONE, value, value };
 }
 
-void CodeGenerator::Visit(BinaryOperationNode& n) { ProcessBinOp(n, CmdType::ARITHM); }
-void CodeGenerator::Visit(ConditionNode& n)       { ProcessBinOp(n, n.op.str == "&&" || n.op.str == "||" ? CmdType::LOG : CmdType::RELAT); }
+void CodeGenerator::Visit(UnaryOperationNode& n)
+{
+    if (const auto value = Folded(n.index)) values.push_back({ std::nullopt, std::nullopt, std::nullopt, value });
+    else EmitUnary((*tokens)[n.op].str);
+}
+
+void CodeGenerator::Visit(BinaryOperationNode& n)
+{
+    if (const auto value = Folded(n.index)) values.push_back({ std::nullopt, std::nullopt, std::nullopt, value });
+    else EmitBinOp((*tokens)[n.op].str, CmdType::ARITHM);
+}
+
+// Conditions are generated even when they are constant: the jump out of the if or loop is emitted along with the comparison
+void CodeGenerator::Visit(ConditionNode& n)       { EmitBinOp((*tokens)[n.op].str, (*tokens)[n.op].type == TokenID::AND || (*tokens)[n.op].type == TokenID::OR ? CmdType::LOG : CmdType::RELAT); }
 
 void CodeGenerator::Visit(IfNode& n)
 {
-    const auto falseLabel = Label::NewLabel(); // if condition(s) is false this jump label is the next elseif condition start or end of if-elseif-else
-    instructions.push_back({ Command{"IfFalse", CmdType::IF }, fetch_instr(n.condition.get()).dest, std::nullopt, falseLabel });
-    if (n.body)
-    {
-        PlainVisit(n.body.get()); // Processed the body of the if or else-if, we skip the rest (via goto) and go to the end of all the chained if-elseif-else
-        instructions.push_back({ Command{"Goto", CmdType::GOTO }, std::nullopt, std::nullopt,  Operand{ CmdType::LABEL, n.parentEndLabel, n.parentEndLabel} });
-    }
+    // Processed the body of the if or else-if, we skip the rest (via goto) and go to the end of all the chained if-elseif-else
+    if (n.body) instructions.push_back({ Command{"Goto", CmdType::GOTO }, std::nullopt, std::nullopt, labels[labels.size() - 2] });
+    else        EmitJump("IfFalse", labels.back());
     // The label signifying the end of this if and potentially the start of another elseif or else
-    instructions.push_back({ Command{"Label", CmdType::LABEL }, std::nullopt, std::nullopt, falseLabel });
+    EmitLabel(labels.back());
+    labels.pop_back();
 }
 
 void CodeGenerator::Visit(IfStatementNode& n)
 {
-    // Label for the end of all the if-elseif-else contained
-    const auto endIfLabel = Label::NewLabel();
-    for (const auto& ifN : n.ifNodes) 
-    { 
-        // Set each child if-elseif jump label (if the branch is taken) to the end of this parent if
-        ifN->parentEndLabel = endIfLabel.name; 
-        PlainVisit(ifN.get()); 
-    }
-    if (n.elseBody) PlainVisit(n.elseBody.get());  // No need to attach a goto end here, this is end of the if-else-if-else chain anyway
-    instructions.push_back({ Command{"Label", CmdType::LABEL }, std::nullopt, std::nullopt, endIfLabel });
+    // No need to attach a goto end to the else, this is end of the if-else-if-else chain anyway
+    EmitLabel(labels.back());
+    labels.pop_back();
 }
 
-void CodeGenerator::Visit(IterationNode& n) { assert(("Code Generator visited base IterationNode class?!", false)); }
-
 void CodeGenerator::Visit(WhileNode& n)
 {
-    const auto startLabel = Label::NewLabel();
-    instructions.push_back({ Command{"Label", CmdType::LABEL }, std::nullopt, std::nullopt, startLabel });
-    const auto endLabel = Label::NewLabel();
-    instructions.push_back({ Command{"IfFalse", CmdType::IF }, fetch_instr(n.condition.get()).dest, std::nullopt, endLabel });
-    if (n.body)
-    {
-        PlainVisit(n.body.get()); // Processed the body of the while, we go back to the condition
-        instructions.push_back({ Command{"Goto", CmdType::GOTO }, std::nullopt, std::nullopt, startLabel });
-    }
-    instructions.push_back({ Command{"Label", CmdType::LABEL }, std::nullopt, std::nullopt, endLabel });
+    // Processed the body of the while, we go back to the condition
+    if (n.body) instructions.push_back({ Command{"Goto", CmdType::GOTO }, std::nullopt, std::nullopt, labels[labels.size() - 2] });
+    else        EmitJump("IfFalse", labels.back());
+    EmitLabel(labels.back());
+    labels.resize(labels.size() - 2);
 }
 
 void CodeGenerator::Visit(DoWhileNode& n)
 {
-    const auto startLabel = Label::NewLabel();
-    instructions.push_back({ Command{"Label", CmdType::LABEL }, std::nullopt, std::nullopt, startLabel });
+    // The condition holds no statements, so no other do_while's, and gets a walker of its own
     if (n.body)
     {
-        PlainVisit(n.body.get());
-        instructions.push_back({ Command{"If", CmdType::IF }, fetch_instr(n.condition.get()).dest, std::nullopt, startLabel });
+        conditionWalker.Walk(*n.condition, [this](ASTNode& c, ASTNode* parent) { return Enter(c, parent); }, [this](ASTNode& c, ASTNode* parent) { Exit(c, parent); });
+        EmitJump("If", labels.back());
     }
+    labels.pop_back();
 }
 
-void CodeGenerator::Visit(CompoundStatementNode& n) { for (const auto& statement : n.statements) PlainVisit(statement.get()); }
-void CodeGenerator::Visit(StatementBlockNode& n)    { for (const auto& statement : n.statements) PlainVisit(statement.get()); }
-void CodeGenerator::Visit(DeclareStatementNode& n)  { Return(GetValue(n.identifier.get())); }
-
-void CodeGenerator::ProcessAssignment(const BinaryASTNode& n)
-{
-//#ifdef OPTIMIZE_TEMPS
-//    // Get the instruction from the expression (temporary with expression, literal or identifier) from the right
-//    const auto src2 = fetch_instr(n.right.get());
-//    // If its an operation (not just an identifier or literal)
-//    if (src2.op.has_value())
-//    {
-//        // Remove the previous instruction
-//        instructions.pop_back();
-//        // And reform it as a direct assignment of the operation to your left operand
-//        instructions.push_back({ src2.op, src2.src1, src2.src2, GetValue(n.left.get()).dest });
-//    }
-//    // Just a literal or identifier, assign it to your left
-//    else instructions.push_back({ n.op.first, src2.dest, std::nullopt, GetValue(n.left.get()).dest });
-//#else
-    // Assign the expression to your left
-    instructions.push_back({ Command{ n.op.str, CmdType::COPY }, fetch_instr(n.right.get()).dest, std::nullopt, GetValue(n.left.get()).dest });
-//#endif // OPTIMIZE_TEMPS
+void CodeGenerator::Visit(CompoundStatementNode& n) {}
+void CodeGenerator::Visit(StatementBlockNode& n)    {}
+void CodeGenerator::Visit(DeclareStatementNode& n)  {}
+
+void CodeGenerator::EmitAssignment(const std::string_view op, const Operand& value, const Operand& variable)
+{
+    // A compound assignment (x op= y) is carried out as x = x op y
+    if (op.size() > 1) instructions.push_back({ Command{ std::string(op.substr(0, op.size() - 1)), CmdType::ARITHM }, variable, value, variable });
+    else               instructions.push_back({ Command{ std::string(op), CmdType::COPY }, value, std::nullopt, variable });
 }
 
-void CodeGenerator::Visit(DeclareAssignNode& n)   { ProcessAssignment(n); }
-void CodeGenerator::Visit(AssignStatementNode& n) { ProcessAssignment(n); }
+void CodeGenerator::Visit(DeclareAssignNode& n)
+{
+    // Assign the expression to the variable declared
+    const auto value = fetch_value(values.back()).dest;
+    values.pop_back();
+    const IdentifierNode& variable = *static_cast<DeclareStatementNode*>(n.left)->identifier;
+    EmitAssignment((*tokens)[n.op].str, *value, Variable((*tokens)[variable.token].str, variable.index));
+}
+
+void CodeGenerator::Visit(AssignStatementNode& n)
+{
+    // Assign the expression to your left
+    const auto value = fetch_value(values.back()).dest;
+    values.pop_back();
+    EmitAssignment((*tokens)[n.op].str, *value, *values.back().dest);
+    values.pop_back();
+}
 
 void CodeGenerator::Visit(ReturnStatementNode& n)
 {
-    instructions.push_back({ Command{ "Return", CmdType::RET }, std::nullopt, std::nullopt, GetValue(n.expr.get()).dest });
+    instructions.push_back({ Command{ "Return", CmdType::RET }, std::nullopt, std::nullopt, values.back().dest });
+    values.pop_back();
 }
 
 void CodeGenerator::Visit(EmptyStatementNode& n) {}
 
+void CodeGenerator::Generate(const NodeIndex i, const NodeIndex parent)
+{
+    const FlatNode& n = (*flat)[i];
+    if (parent != FlatAST::none && (*flat)[parent].kind == NodeKind::DoWhile && (*flat)[parent].firstChild == i) return;
+    switch (n.kind)
+    {
+    case NodeKind::Integer:
+    {
+        const std::string value = std::to_string(flat->GetValue(i));
+        values.push_back({ std::nullopt, std::nullopt, std::nullopt, Operand{CmdType::NONE, value, value} });
+        return;
+    }
+    case NodeKind::Identifier:
+        values.push_back({ std::nullopt, std::nullopt, std::nullopt, Variable((*tokens)[n.token].str, i) });
+        return;
+    case NodeKind::UnaryOperation:
+        if (const auto value = Folded(i)) values.push_back({ std::nullopt, std::nullopt, std::nullopt, value });
+        else EmitUnary((*tokens)[n.token].str);
+        return;
+    case NodeKind::BinaryOperation:
+        if (const auto value = Folded(i)) values.push_back({ std::nullopt, std::nullopt, std::nullopt, value });
+        else EmitBinOp((*tokens)[n.token].str, CmdType::ARITHM);
+        return;
+    case NodeKind::Condition:
+        EmitBinOp((*tokens)[n.token].str, (*tokens)[n.token].type == TokenID::AND || (*tokens)[n.token].type == TokenID::OR ? CmdType::LOG : CmdType::RELAT);
+        return;
+    case NodeKind::If:
+        instructions.push_back({ Command{"Goto", CmdType::GOTO }, std::nullopt, std::nullopt, labels[labels.size() - 2] });
+        EmitLabel(labels.back());
+        labels.pop_back();
+        return;
+    case NodeKind::IfStatement:
+        EmitLabel(labels.back());
+        labels.pop_back();
+        return;
+    case NodeKind::While:
+        instructions.push_back({ Command{"Goto", CmdType::GOTO }, std::nullopt, std::nullopt, labels[labels.size() - 2] });
+        EmitLabel(labels.back());
+        labels.resize(labels.size() - 2);
+        return;
+    case NodeKind::DoWhile:
+        conditionWalker.Walk(*flat, n.firstChild, [this](const NodeIndex c, const NodeIndex p) { return Enter(c, p); }, [this](const NodeIndex c, const NodeIndex p) { Generate(c, p); });
+        EmitJump("If", labels.back());
+        labels.pop_back();
+        return;
+    case NodeKind::DeclareAssign:
+    {
+        const auto value = fetch_value(values.back()).dest;
+        values.pop_back();
+        const NodeIndex variable = (*flat)[n.firstChild].firstChild;
+        EmitAssignment((*tokens)[n.token].str, *value, Variable((*tokens)[(*flat)[variable].token].str, variable));
+        return;
+    }
+    case NodeKind::AssignStatement:
+    {
+        const auto value = fetch_value(values.back()).dest;
+        values.pop_back();
+        EmitAssignment((*tokens)[n.token].str, *value, *values.back().dest);
+        values.pop_back();
+        return;
+    }
+    case NodeKind::ReturnStatement:
+        instructions.push_back({ Command{ "Return", CmdType::RET }, std::nullopt, std::nullopt, values.back().dest });
+        values.pop_back();
+        return;
+    default:  // Compound statements, statement blocks, declarations and empty statements
+        return;
+    }
+}
+
 /* TODO:
     -Mul and Div require special registers
     -Mov mem, mem is not possible?
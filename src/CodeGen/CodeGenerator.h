@@ -1,6 +1,8 @@
 #pragma once
 #include <optional>
 
+#include "../AST/ASTWalker.h"
+#include "../AST/FlatAST.h"
 #include "../AST/Visitor.h"
 #include "../Util/ModuleManager.h"
 
@@ -8,9 +10,9 @@
 // Optimization flag enables the recycling of already processed temporary variables
 // and prevents -> _t0 = a * b -> c = _t0 and instead optimizes to c = a * b.
 #ifdef OPTIMIZE_TEMPS
-#define fetch_instr(x) Temporary::CheckAndRecycle(GetValue(x))
+#define fetch_value(x) Temporary::CheckAndRecycle(x)
 #else
-#define fetch_instr(x) GetValue(x)
+#define fetch_value(x) (x)
 #endif // OPTIMIZE_TEMPS
 
 // Type of intermediate representation commands/instructions - Used in assembly generation
@@ -27,6 +29,7 @@ struct Operand
     CmdType type; // this is encoded twice for command and operand! remove from here?
     std::string name;
     std::string address;
+    int32_t frameOffset = 0;  // From ebp, variables only
 };
 
 struct Quadruples
@@ -46,7 +49,7 @@ private:
 public:
     static const Operand NewTemporary() { return Operand{ CmdType::REG, "_t" + std::to_string(tempCount), "_t" + std::to_string(tempCount++) }; } // address? const?
     // If a temporary is passed to it, it drops the counter effectively recycling that temporary
-    // This should never be called by itself and rather through the obtain_source macro. I know bad design...
+    // This should never be called by itself and rather through the fetch_value macro. I know bad design...
     static const Quadruples CheckAndRecycle(const Quadruples& potentialTemporary)
     { 
         // What if an identifier starting with _t is passed to it...
@@ -70,24 +73,57 @@ public:
 };
 
 
-// CodeGenerator derives from ValueGetter by the 'Curiously Recurring Template Pattern' so that 
-// the ValueGetter can instantiate the Evaluator itself. It also implements INodeVisitor interface 
-// the conventional way - overriding all overloads of Visit virtual method for every type of supported node.
-class CodeGenerator : public ValueGetter<CodeGenerator, ASTNode*, Quadruples>, public ASTNodeVisitor,
-                      public IObserver<>, public IObserver<ASTNode>, public IObserver<bool>
+struct SemanticResult;
+struct ExpressionInfo;
+
+// Walks the AST with an ASTWalker, so generating code takes the same call stack however deeply the tree nests.
+// A node's code is generated once it is exited (through a Visit overload, called by Dispatch, for the pointer tree),
+// from the values its children left on a stack of their own. Whatever has to come in between its children (the jump
+// out of an if or loop after its condition) is generated as the later child is entered
+class CodeGenerator : public IObserver<>, public IObserver<SyntaxTree>, public IObserver<SemanticResult>
 {
 private:
-    static std::vector<Quadruples> instructions;
+    std::vector<Quadruples> instructions;
+    ASTWalker walker;
+    ASTWalker conditionWalker;       // A do_while's condition is its first child, but its code comes after the body's
+    std::vector<Quadruples> values;  // Of the expressions exited whose parent has not been yet, innermost last
+    std::vector<Operand> labels;     // Of the control flow statements being generated, innermost last
+    const TokenStream* tokens = nullptr;
+    // The semantic analyzer's, keyed by node index
+    const std::vector<int32_t>* frameSlots = nullptr;
+    uint32_t frameSize = 0;
+    const std::vector<ExpressionInfo>* expressions = nullptr;
 
     std::stringstream tac, x86;
 
     ASTNode* root = nullptr;
+    const FlatAST* flat = nullptr;
+    size_t nodeCount = 0;
 
     bool shouldRun  = false;
     bool semSuccess = false;
 
-    void ProcessAssignment(const BinaryASTNode& n);
-    void ProcessBinOp(const BinaryASTNode& n, CmdType type);
+    // Code for what is in between the children of a node, and what is before any of them, keyed by the node's kind.
+    // False for nodes not to be walked into
+    void EnterChild(const NodeKind parent, const bool first);
+    bool Enter(const NodeKind kind, const NodeIndex i);
+    bool Enter(ASTNode& n, ASTNode* parent);
+    bool Enter(const NodeIndex i, const NodeIndex parent);
+    void Exit(ASTNode& n, ASTNode* parent);
+    // The same generation over a FlatAST, for node i once its children are done
+    void Generate(const NodeIndex i, const NodeIndex parent);
+    void GenerateCode();
+
+    // Take their operands off the value stack
+    void EmitUnary(const std::string_view op);
+    void EmitBinOp(const std::string_view op, const CmdType type);
+    void EmitJump(const char* jump, const Operand& label);
+    void EmitAssignment(const std::string_view op, const Operand& value, const Operand& variable);
+    void EmitLabel(const Operand& label);
+    Operand Variable(const std::string_view name, const NodeIndex i);
+    const std::string Location(const Operand& o) const;
+    // The literal an expression the semantic analyzer folded is generated as, none if node i is not one
+    std::optional<Operand> Folded(const NodeIndex i) const;
     const std::string ReverseOp(const std::string& op) const;
 
     void GenerateTAC();
@@ -95,28 +131,27 @@ private:
 public:
     std::string GetTAC() const { return tac.str(); }
     std::string Getx86() const { return x86.str(); }   // TEMPS - NO COPY
-
-    // Inherited via ASTNodeVisitor
-    void Visit(ASTNode& n)               override;
-    void Visit(UnaryASTNode& n)          override;
-    void Visit(BinaryASTNode& n)         override;
-    void Visit(IntegerNode& n)           override;
-    void Visit(IdentifierNode& n)        override;
-    void Visit(UnaryOperationNode& n)    override;
-    void Visit(BinaryOperationNode& n)   override;
-    void Visit(ConditionNode& n)         override;
-    void Visit(IfNode& n)                override;
-    void Visit(IfStatementNode& n)       override;
-    void Visit(IterationNode& n)         override;
-    void Visit(WhileNode& n)             override;
-    void Visit(DoWhileNode& n)           override;
-    void Visit(StatementBlockNode& n)    override;
-    void Visit(CompoundStatementNode& n) override;
-    void Visit(DeclareStatementNode& n)  override;
-    void Visit(DeclareAssignNode& n)     override;
-    void Visit(AssignStatementNode& n)   override;
-    void Visit(ReturnStatementNode& n)   override;
-    void Visit(EmptyStatementNode& n)    override;
+    // Times generating the intermediate code of the current AST over and over, and logs the cost per node
+    // next to what constructing a generator per node, as every fetched value used to, would add to it
+    void Benchmark(const size_t runs = 200);
+
+    // Visited through Dispatch
+    void Visit(IntegerNode& n);
+    void Visit(IdentifierNode& n);
+    void Visit(UnaryOperationNode& n);
+    void Visit(BinaryOperationNode& n);
+    void Visit(ConditionNode& n);
+    void Visit(IfNode& n);
+    void Visit(IfStatementNode& n);
+    void Visit(WhileNode& n);
+    void Visit(DoWhileNode& n);
+    void Visit(StatementBlockNode& n);
+    void Visit(CompoundStatementNode& n);
+    void Visit(DeclareStatementNode& n);
+    void Visit(DeclareAssignNode& n);
+    void Visit(AssignStatementNode& n);
+    void Visit(ReturnStatementNode& n);
+    void Visit(EmptyStatementNode& n);
 
     // Inherited via IObserver - Observing Module Manager
     virtual bool ShouldRun()  const override  { return shouldRun; }
@@ -125,8 +160,8 @@ public:
     virtual void Reset()            override;
 
     // Inherited via IObserver - Observing AST Changes
-    virtual void Update(ASTNode* n) override  { root = n; }
+    virtual void Update(SyntaxTree* ast) override;
 
     // Inherited via IObserver - Observing Semantic Analyzer State
-    virtual void Update(bool* run)  override  { semSuccess = !*run; }  // ???
+    virtual void Update(SemanticResult* result) override;
 };
\ No newline at end of file
@@ -0,0 +1,9 @@
+#include "AtomTable.h"
+
+Atom AtomTable::Intern(const std::string_view spelling)
+{
+    if (const auto it = atoms.find(spelling); it != atoms.end()) return it->second;
+    const Atom atom = GetEnd();
+    atoms.emplace(spellings.emplace_back(spelling), atom);
+    return atom;
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Identifiers are told apart by these after lexing, see AtomTable
+using Atom = uint32_t;
+
+// Gives every distinct identifier spelling a small number of its own, its atom, so that later passes compare
+// identifiers and index tables by number rather than by text. Atoms are dense from 1 (0 is no atom) and never
+// taken back one at a time: a spelling keeps its atom across runs until the lexer that owns the table clears it
+class AtomTable
+{
+private:
+    std::deque<std::string> spellings;  // Never moves its strings, the keys below view them
+    std::unordered_map<std::string_view, Atom> atoms;
+public:
+    static constexpr Atom none = 0;
+
+    Atom Intern(const std::string_view spelling);
+    void Clear() { atoms.clear(); spellings.clear(); }
+    // Every atom handed out so far is below this
+    Atom GetEnd() const { return static_cast<Atom>(spellings.size() + 1); }
+    std::string_view GetSpelling(const Atom a) const { return a == none ? std::string_view() : spellings[a - 1]; }
+};
\ No newline at end of file
@@ -1,15 +1,302 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
 #include <TextEditor.h>
 #include "Lexer.h"
+#include "LexerTables.h"
+#include "SimdScan.h"
 #include "../Util/Logger.h"
 
 void Lexer::Update()
 {
     if (!shouldRun) return;
+    shouldRun = false;
 
-    input = editor->GetText();
-    Reset();
+    // Every run lexes into a new stream, an AST built from the previous one keeps that one alive.
+    // If there is a complete previous one, only the part of it around the edit is lexed again.
+    // A freshly opened file is lexed straight from its buffer, the editor may not even hold it yet
+    std::shared_ptr<const SourceBuffer> source = std::move(pendingSource);
+    if (!source && !streaming && !pulling && sourceTokens->size() > 1 && sourceTokens->tabSize == static_cast<size_t>(editor->GetTabSize()))
+        Relex(editor->GetText());
+    else
+    {
+        if (!source) source = std::make_shared<const SourceBuffer>(editor->GetText());
+        const TokenIndex previousCount = static_cast<TokenIndex>(sourceTokens->size());
+        Reset();
+        // Everything is lexed anew, and parsed anew after that: the atoms of the spellings gone from the text go as well
+        atomTable.Clear();
+        sourceTokens = std::make_shared<TokenStream>(std::move(source), editor->GetTabSize());
+        input = sourceTokens->source;
+        lastEdit = { 0, previousCount, 0 };
+        if (streaming)
+        {
+            lexEnd = input.size();
+            pulling = true;
+            Pull();
+            Logger::Info("Streaming tokens to the parser\n");
+            return;
+        }
+        Tokenize();
+        lastEdit.newEnd = static_cast<TokenIndex>(sourceTokens->size());
+    }
+
+    if (!sourceTokens->empty())
+    {
+        Logger::Info("Tokenized input!\n");
+        for (TokenIndex i = 0; i < sourceTokens->size(); ++i) Logger::Debug("{} ", sourceTokens->GetStr(i));
+        Logger::Debug('\n');
+    }
+}
+
+void Lexer::Tokenize()
+{
+    lexEnd = input.size();
+    if (std::min(threadCount, input.size() / minChunkBytes) > 1) TokenizeParallel();
+    else engine == Engine::TableDriven ? TokenizeTableDriven() : TokenizeHandWritten();
+    FinishStream();
+}
+
+// Cheap pass over the text that only follows comments, strings and raw strings, to split it where the lexer
+// will be at the top level: at the start of a line outside of all of them, about every text.size() / chunks bytes.
+// It can be fooled (a digit separator in a hex literal looks like a character literal), TokenizeParallel repairs that
+static std::vector<size_t> FindChunkStarts(const std::string_view text, const size_t chunks)
+{
+    const char* const src = text.data();  // Null terminated, see TokenizeTableDriven
+    const size_t size = text.size();
+    const size_t target = size / chunks;
+    const auto skipPast = [&](const size_t from, const std::string_view closing) {
+        const size_t found = text.find(closing, from);
+        return found == std::string_view::npos ? size : found + closing.size();
+    };
+
+    std::vector<size_t> starts = { 0 };
+    for (size_t i = 0, next = target; i < size;)
+    {
+        const char c = src[i];
+        if (c == '\n')
+        {
+            if (++i >= next && i < size)
+            {
+                starts.push_back(i);
+                next = i + target;
+            }
+        }
+        else if (c == '/' && src[i + 1] == '/') i = skipPast(i, "\n") - 1;  // Leaves the newline to be seen
+        else if (c == '/' && src[i + 1] == '*') i = skipPast(i + 2, "*/");
+        else if (c == '"' && i > 0 && src[i - 1] == 'R')
+        {
+            const size_t open = std::min(text.find('(', i), size);
+            i = skipPast(open, ")" + std::string(text.substr(i + 1, open - i - 1)) + '"');
+        }
+        else if (c == '"' || (c == '\'' && !(i > 0 && std::isdigit(static_cast<unsigned char>(src[i - 1])))))
+        {
+            for (++i; i < size && src[i] != c; ++i) if (src[i] == '\\') ++i;
+            ++i;
+        }
+        else ++i;
+    }
+    starts.push_back(size);
+    return starts;
+}
+
+// Each chunk is lexed on its own thread as if it began at the top level, then the chunks are joined in order.
+// Where a token or comment of one chunk ran into the next, that next chunk started from the wrong place, so it is
+// lexed again from where the previous one really stopped, until it falls in step with what the thread produced
+void Lexer::TokenizeParallel()
+{
+    const std::vector<size_t> starts = FindChunkStarts(input, std::min(threadCount, input.size() / minChunkBytes));
+    const size_t chunks = starts.size() - 1;
+
+    std::vector<std::unique_ptr<Lexer>> workers;
+    std::vector<std::thread> threads;
+    for (size_t k = 0; k < chunks; ++k)
+    {
+        Lexer& worker = *workers.emplace_back(std::make_unique<Lexer>(editor));
+        worker.input = input;
+        worker.engine = engine;
+        worker.benchmarking = benchmarking;
+        worker.deferWarnings = true;
+        worker.sourceIndex = starts[k];
+        worker.lexEnd = starts[k + 1];
+        threads.emplace_back([&worker]() { worker.engine == Engine::TableDriven ? worker.TokenizeTableDriven() : worker.TokenizeHandWritten(); });
+    }
+    for (auto& thread : threads) thread.join();
+
+    // The repairs are lexed here, with their warnings held back too so that all of them come out in source order
+    deferWarnings = true;
+    std::vector<uint32_t> unknownOffsets;
+    size_t stoppedAt = 0;
+    for (size_t k = 0; k < chunks; ++k)
+    {
+        const Lexer& worker = *workers[k];
+        const TokenStream& chunk = *worker.sourceTokens;
+        const TokenIndex count = static_cast<TokenIndex>(chunk.size());
+        TokenIndex keepFrom = 0;
+        const bool repair = stoppedAt != starts[k];
+        if (repair)
+        {
+            sourceIndex = stoppedAt;
+            lexEnd = starts[k + 1];
+            previousTokens = worker.sourceTokens;
+            resyncFrom = 0;
+            resyncShift = 0;
+            resyncToken = 0;
+            resyncCount = count;
+            engine == Engine::TableDriven ? TokenizeTableDriven() : TokenizeHandWritten();
+            keepFrom = sourceIndex < lexEnd ? resyncToken : count;
+            previousTokens.reset();
+            resyncFrom = SIZE_MAX;
+        }
+        // Unless the repair never caught up with the chunk, this chunk's thread decides where the next one should begin
+        stoppedAt = repair && keepFrom == count ? sourceIndex : worker.sourceIndex;
+
+        sourceTokens->types.insert(sourceTokens->types.end(), chunk.types.begin() + keepFrom, chunk.types.end());
+        sourceTokens->offsets.insert(sourceTokens->offsets.end(), chunk.offsets.begin() + keepFrom, chunk.offsets.end());
+        sourceTokens->lengths.insert(sourceTokens->lengths.end(), chunk.lengths.begin() + keepFrom, chunk.lengths.end());
+        unknownOffsets.insert(unknownOffsets.end(), unknowns.begin(), unknowns.end());
+        unknowns.clear();
+        if (keepFrom < count)
+            for (const uint32_t offset : worker.unknowns) if (offset >= chunk.offsets[keepFrom]) unknownOffsets.push_back(offset);
+    }
+    deferWarnings = false;
+    sourceIndex = lexEnd = input.size();
+
+    if (!benchmarking) for (const uint32_t offset : unknownOffsets) Logger::Warn("Lexer encountered unknown token '{}'\n", input[offset]);
+}
+
+void Lexer::Pull()
+{
+    if (!pulling) return;
+    // Picks up at the top of the main loop where the last batch stopped, which needs nothing but sourceIndex
+    pullLimit = sourceTokens->size() + pullBatch;
+    engine == Engine::TableDriven ? TokenizeTableDriven() : TokenizeHandWritten();
+    pullLimit = SIZE_MAX;
+    if (sourceIndex < lexEnd) return;
+
+    pulling = false;
+    FinishStream();
+    lastEdit.newEnd = static_cast<TokenIndex>(sourceTokens->size());
+}
+
+void Lexer::Drain()
+{
+    while (pulling) Pull();
+}
+
+void Lexer::FinishStream()
+{
+    // The last token is always the end of file, to guard against accessing past the end of sourceTokens.
+    // It sits at the start of the last token's line and has no text in the source, which is how
+    // TokenStream tells it apart from a stray '\032'
+    if (!sourceTokens->empty())
+    {
+        const size_t lastNewline = input.rfind('\n', sourceTokens->offsets.back());
+        sourceTokens->Append(TokenID::ENDF, lastNewline == std::string_view::npos ? 0 : static_cast<uint32_t>(lastNewline + 1), 0);
+    }
+
+    // Relex already has the atoms of all of them, kept from the previous stream or interned as it lexed them
+    sourceTokens->IndexIdentifiers();
+    if (sourceTokens->atoms.empty())
+        for (TokenIndex i = 0; i < sourceTokens->size(); ++i)
+            if (sourceTokens->GetType(i) == TokenID::IDENTIFIER) sourceTokens->atoms.push_back(atomTable.Intern(sourceTokens->GetStr(i)));
+    sourceTokens->atomEnd = atomTable.GetEnd();
+    sourceTokens->Seal();
+}
+
+void Lexer::Relex(std::string text)
+{
+    const std::shared_ptr<const TokenStream> previous = sourceTokens;
+    const std::string_view old = previous->source;
+
+    // The editor does not report its edits, so the edit is taken to be whatever lies between
+    // the common prefix and the common suffix of the old and the new text
+    const size_t start = std::mismatch(old.begin(), old.end(), text.begin(), text.end()).first - old.begin();
+    size_t suffix = 0;
+    while (suffix < std::min(old.size(), text.size()) - start && old[old.size() - 1 - suffix] == text[text.size() - 1 - suffix]) ++suffix;
+    const size_t oldEnd = old.size() - suffix;
+    const size_t newEnd = text.size() - suffix;
+
+    sourceIndex = 0;
+    currentTokenIndex = 0;
+    if (start == oldEnd && start == newEnd)
+    {
+        // Nothing changed, but a file lexed straight from its mapping is done with it once the editor holds the text:
+        // saving writes over the file, under every token (and the AST) still viewing it. The same tokens view the
+        // editor's copy from then on
+        if (previous->buffer->IsMapped())
+        {
+            sourceTokens = std::make_shared<TokenStream>(std::move(text), previous->tabSize);
+            input = sourceTokens->source;
+            sourceTokens->types = previous->types;
+            sourceTokens->offsets = previous->offsets;
+            sourceTokens->lengths = previous->lengths;
+            sourceTokens->atoms = previous->atoms;
+            sourceTokens->identifiers = previous->identifiers;
+            sourceTokens->identifiersBefore = previous->identifiersBefore;
+            sourceTokens->atomEnd = previous->atomEnd;
+        }
+        lastEdit = { 0, 0, 0, previous.get() };
+        return;
+    }
+
+    // Restart at the last token the main loop began (one with a gap before it, so not a piece of a string)
+    // far enough before the edit that the token preceding it never peeked into the edited text
+    const auto& offsets = previous->offsets;
+    const auto& lengths = previous->lengths;
+    const TokenIndex count = static_cast<TokenIndex>(previous->size() - 1);  // The end of file token is always redone
+    TokenIndex first = start < maxLookahead ? 0 : static_cast<TokenIndex>(std::upper_bound(offsets.begin(), offsets.begin() + count, start - maxLookahead) - offsets.begin());
+    if (first > 0) --first;
+    while (first > 0 && offsets[first - 1] + lengths[first - 1] >= offsets[first]) --first;
 
-    while (sourceIndex < input.size())  // Missing ':', '::', '::*' (??), '>*' (??) and potentially others
+    sourceTokens = std::make_shared<TokenStream>(std::move(text), previous->tabSize);
+    input = sourceTokens->source;
+    sourceTokens->types.assign(previous->types.begin(), previous->types.begin() + first);
+    sourceTokens->offsets.assign(offsets.begin(), offsets.begin() + first);
+    sourceTokens->lengths.assign(lengths.begin(), lengths.begin() + first);
+    sourceTokens->atoms.assign(previous->atoms.begin(), previous->atoms.begin() + previous->CountIdentifiers(first));
+    sourceIndex = first == 0 ? 0 : offsets[first];
+
+    previousTokens = previous;
+    resyncFrom = newEnd;
+    resyncShift = static_cast<ptrdiff_t>(newEnd) - static_cast<ptrdiff_t>(oldEnd);
+    resyncToken = first;
+    resyncCount = count;
+    lexEnd = input.size();
+    engine == Engine::TableDriven ? TokenizeTableDriven() : TokenizeHandWritten();
+
+    // Stopped early means it got back in step with the previous stream, the rest of which only moves by the edit's size
+    const TokenIndex relexedEnd = static_cast<TokenIndex>(sourceTokens->size());
+    const TokenIndex resumeAt = sourceIndex < lexEnd ? resyncToken : count;
+    for (TokenIndex i = first; i < relexedEnd; ++i)
+        if (sourceTokens->GetType(i) == TokenID::IDENTIFIER) sourceTokens->atoms.push_back(atomTable.Intern(sourceTokens->GetStr(i)));
+    sourceTokens->atoms.insert(sourceTokens->atoms.end(), previous->atoms.begin() + previous->CountIdentifiers(resumeAt), previous->atoms.begin() + previous->CountIdentifiers(count));
+    for (TokenIndex i = resumeAt; i < count; ++i)
+        sourceTokens->Append(previous->GetType(i), static_cast<uint32_t>(offsets[i] + resyncShift), lengths[i]);
+    FinishStream();
+
+    lastEdit = { first, resumeAt, relexedEnd, previous.get() };
+    previousTokens.reset();
+    resyncFrom = SIZE_MAX;
+    sourceIndex = 0;
+    Logger::Info("Re-lexed tokens {} to {}, replacing {} to {} of the previous {}\n", first, relexedEnd, first, resumeAt, count);
+}
+
+bool Lexer::Resynced()
+{
+    if (sourceIndex < resyncFrom) return false;
+    // At the start of a token, past the edit. If the previous run also started a token from its main loop
+    // at the same place in the unchanged text, everything from here on is what it produced
+    const TokenStream& previous = *previousTokens;
+    const size_t oldIndex = sourceIndex - resyncShift;
+    while (resyncToken < resyncCount && previous.offsets[resyncToken] < oldIndex) ++resyncToken;
+    return resyncToken < resyncCount && previous.offsets[resyncToken] == oldIndex &&
+        (resyncToken == 0 || previous.offsets[resyncToken - 1] + previous.lengths[resyncToken - 1] < oldIndex);
+}
+
+void Lexer::TokenizeHandWritten()
+{
+    while (sourceIndex < lexEnd && sourceTokens->size() < pullLimit && !Resynced())  // Missing ':', '::', '::*' (??), '>*' (??) and potentially others
     {
         const char current = Peek();
         if (std::isspace(current))
@@ -21,8 +308,8 @@ void Lexer::Update()
         {
         case '[': case ']': case '{': case '}': case '(':
         case ')': case ';': case ',': case '?': case '~': 
-            AddToken({ { current }, pos });
             Advance();
+            AddToken(sourceIndex - 1);
             continue;
         case '>': case '<':
             StartToken();
@@ -37,7 +324,7 @@ void Lexer::Update()
                     continue;
                 }
                 // '<<' OR '>>'
-                AddToken({ input.substr(tokenStartIndex, sourceIndex - tokenStartIndex), tokenStartPos });
+                AddToken(tokenStartIndex);
                 continue;
             }
             if (Peek() == '=')
@@ -47,7 +334,7 @@ void Lexer::Update()
                 continue;
             }
             // '>' OR '<'
-            AddToken({ { current }, tokenStartPos });
+            AddToken(tokenStartIndex);
             continue;
         case '+': case '-': case '&': case '|': case '=':
             StartToken();
@@ -65,7 +352,7 @@ void Lexer::Update()
                 continue;
             }
             // '+' OR '-' OR '&' OR '|' OR '='
-            AddToken({ { current }, tokenStartPos });
+            AddToken(tokenStartIndex);
             continue;
         case '*': case '!': case '^': case '%':
             StartToken();
@@ -77,7 +364,7 @@ void Lexer::Update()
                 continue;
             }
             // '*' OR '!' OR '^' OR '%'
-            AddToken({ { current }, tokenStartPos });
+            AddToken(tokenStartIndex);
             continue;
         case '/':                 // Comments or Division or DivisionAssignment
             if (Peek(1) == '/')
@@ -111,80 +398,204 @@ void Lexer::Update()
                 continue;
             }
             // '/'
-            AddToken({ { current }, pos });
             Advance();
+            AddToken(sourceIndex - 1);
             continue;
         default: if (IsQuote(TokenID::S_QUOTE) || IsQuote(TokenID::D_QUOTE) || IsRawString() || IsIdentifier(current) || IsNumber(current)) continue;
         }   
 
         // No clue what it is, it will be added as unknown
-        Logger::Warn("Lexer encountered unknown token '{}'\n", current);
-        Advance();
-        AddToken({ { current }, pos });
+        AddUnknownToken();
     }
+}
 
-    shouldRun = false;
-    if (!sourceTokens.empty())
+// Same tokens as TokenizeHandWritten, but every decision is a lookup in the tables of LexerTables.h
+// rather than locale aware ctype calls, and each character class goes straight to its own scanner.
+// Runs of whitespace, identifier characters and comment/literal bodies are skipped with the
+// vectorised kernels of SimdScan.h.
+void Lexer::TokenizeTableDriven()
+{
+    // The source buffer is a std::string, so there is always a '\0' (CharClass::END) one past its end
+    const char* const src = input.data();
+    const char* const end = src + input.size();
+    while (sourceIndex < lexEnd && sourceTokens->size() < pullLimit && !Resynced())
     {
-        // The last token is always the end of file, to guard against accessing past the end of sourceTokens
-        sourceTokens.push_back({ "EOF", { sourceTokens.back().coords.line, 1 }, TokenID::ENDF });
-        Logger::Info("Tokenized input!\n");
-        for (const auto& tok : sourceTokens) Logger::Debug("{} ", tok.str);
-        Logger::Debug('\n');
+        switch (ClassOf(src[sourceIndex]))
+        {
+        case CharClass::SPACE: case CharClass::NEWLINE:
+            Advance(Scan::SkipSpaces(src + sourceIndex, end) - (src + sourceIndex));
+            continue;
+        case CharClass::PREFIX:
+            if (IsQuote(TokenID::S_QUOTE) || IsQuote(TokenID::D_QUOTE) || IsRawString()) continue;
+            [[fallthrough]];
+        case CharClass::LETTER:
+            StartToken();
+            Advance(Scan::SkipIdentifier(src + sourceIndex, end) - (src + sourceIndex));
+            AddToken(tokenStartIndex, TokenID::IDENTIFIER);
+            continue;
+        case CharClass::QUOTE:
+            if (IsQuote(TokenID::S_QUOTE) || IsQuote(TokenID::D_QUOTE)) continue;
+            break;
+        case CharClass::DIGIT: case CharClass::DOT:
+            if (IsNumber(src[sourceIndex])) continue;
+            break;
+        case CharClass::SLASH:
+            if (src[sourceIndex + 1] == '/')
+            {
+                // Single Line Comment - Ignore It
+                Advance(Scan::FindLineEnd(src + sourceIndex, end) - (src + sourceIndex));
+                continue;
+            }
+            if (src[sourceIndex + 1] == '*')
+            {
+                // Multi Line Comment - Ignore it, up to and including the closing '*/' if there is one
+                Advance(2);
+                const char* close = src + sourceIndex;
+                while (*(close = Scan::FindAny(close, end, '*', '*')) && close[1] != '/') ++close;
+                Advance(close - (src + sourceIndex));
+                if (src[sourceIndex]) Advance(2);
+                continue;
+            }
+            [[fallthrough]];
+        case CharClass::LT:    case CharClass::GT:    case CharClass::PLUS:  case CharClass::MINUS:
+        case CharClass::AMP:   case CharClass::PIPE:  case CharClass::EQUAL: case CharClass::STAR:
+        case CharClass::BANG:  case CharClass::CARET: case CharClass::PERCENT: case CharClass::PUNCT:
+            StartToken();
+            Advance(operatorDfa.Match(src + sourceIndex));
+            AddToken(tokenStartIndex);
+            continue;
+        default: break;
+        }
+
+        AddUnknownToken();
+    }
+}
+
+void Lexer::AddUnknownToken()
+{
+    if (deferWarnings)     unknowns.push_back(static_cast<uint32_t>(sourceIndex));
+    else if (!benchmarking) Logger::Warn("Lexer encountered unknown token '{}'\n", input[sourceIndex]);
+    Advance();
+    AddToken(sourceIndex - 1);
+}
+
+void Lexer::Benchmark(const size_t minBytes)
+{
+    Drain();
+    const std::string text = editor->GetText();
+    if (text.empty()) { Logger::Warn("Nothing to benchmark the lexer on\n"); return; }
+
+    // Repeat the editor's contents until the input is large enough to time reliably
+    std::string source;
+    source.reserve(minBytes + text.size() + 1);
+    while (source.size() < minBytes) source.append(text).push_back('\n');
+
+    // The current stream is put back afterwards, and the next relex takes its atoms: the runs intern into a table of
+    // their own, not the one they came from
+    const auto current = sourceTokens;
+    AtomTable atoms = std::move(atomTable);
+    atomTable.Clear();
+    const Engine selected = engine;
+    const Scan::Level selectedLevel = Scan::GetLevel();
+    const size_t selectedThreads = threadCount;
+    threadCount = 1;
+    benchmarking = true;
+
+    // The hand-written engine first, as the reference, then the table-driven one at every scan level the CPU has
+    std::vector<std::pair<Engine, Scan::Level>> runs = { { Engine::HandWritten, Scan::Level::Scalar } };
+    for (int lvl = 0; lvl <= static_cast<int>(Scan::GetSupportedLevel()); ++lvl)
+        runs.push_back({ Engine::TableDriven, static_cast<Scan::Level>(lvl) });
+
+    std::shared_ptr<const TokenStream> reference;
+    const auto sameTokens = [&reference](const TokenStream& tokens) {
+        return reference->types == tokens.types && reference->offsets == tokens.offsets && reference->lengths == tokens.lengths;
+    };
+    for (const auto& [e, lvl] : runs)
+    {
+        Reset();
+        sourceTokens = std::make_shared<TokenStream>(source, editor->GetTabSize());
+        input = sourceTokens->source;
+        engine = e;
+        Scan::SetLevel(lvl);
+
+        const auto start = std::chrono::steady_clock::now();
+        Tokenize();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        Logger::Info("{} lexer: {} bytes, {} tokens ({:.1f} bytes each) in {:.3f}s - {:.1f} MB/s\n",
+            e == Engine::HandWritten ? std::string("Hand-written") : std::string("Table-driven (") + Scan::GetLevelName(lvl) + ")",
+            source.size(), sourceTokens->size(), sourceTokens->GetBytesPerToken(), elapsed.count(), source.size() / elapsed.count() / (1024.0 * 1024.0));
+
+        if (!reference) reference = sourceTokens;
+        else if (!sameTokens(*sourceTokens))
+            Logger::Error("Lexer engines produced different tokens!\n");
+    }
+
+    // Scaling of the chunked lexer with the selected engine, on every thread count up to 16
+    engine = selected;
+    Scan::SetLevel(selectedLevel);
+    for (size_t threads = 1; threads <= 16; threads *= 2)
+    {
+        Reset();
+        sourceTokens = std::make_shared<TokenStream>(source, editor->GetTabSize());
+        input = sourceTokens->source;
+        threadCount = threads;
+
+        const auto start = std::chrono::steady_clock::now();
+        Tokenize();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        Logger::Info("Chunked lexer, {} thread(s): {:.3f}s - {:.1f} MB/s\n", threads, elapsed.count(), source.size() / elapsed.count() / (1024.0 * 1024.0));
+        if (!sameTokens(*sourceTokens))
+            Logger::Error("Chunked lexing with {} thread(s) produced different tokens!\n", threads);
     }
+    threadCount = selectedThreads;
+
+    benchmarking = false;
+    Scan::SetLevel(selectedLevel);
+    Reset();
+    sourceTokens = current;
+    input = sourceTokens->source;
+    atomTable = std::move(atoms);
 }
 
 void Lexer::StartToken()
 {
     tokenStartIndex = sourceIndex;
-    tokenStartPos = pos;
 }
 
 void Lexer::SubmitToken()
 {
     Advance();
-    AddToken({ input.substr(tokenStartIndex, sourceIndex - tokenStartIndex), tokenStartPos });
+    AddToken(tokenStartIndex);
 }
 
-char Lexer::Advance(const size_t amount)
+void Lexer::AddToken(const size_t start, const TokenID tokenType)
 {
-    for (int i = 0; i < amount; ++i)
-    {
-        const char c = input[sourceIndex++];
-        if (c == '\n')
-        {
-            pos.line++;
-            pos.col = 1;
-        }
-        else if (c == '\t') pos.col += editor->GetTabSize();
-        else pos.col++;
-    }
-    return input[sourceIndex - 1];
-}
-
-void Lexer::AddToken(const Token& token)
-{
-    const auto [it, success] = tokens.emplace(token.str, TokenID::UNKNOWN);
-    if (success && token.type != TokenID::UNKNOWN) it->second = token.type;
-    sourceTokens.push_back({ token.str, token.coords, it->second });
+    const std::string_view str = input.substr(start, sourceIndex - start);
+    // Only identifiers (keywords) and untyped lexemes (operators) need classifying, literals keep their type
+    TokenID type = tokenType;
+    if      (type == TokenID::IDENTIFIER) type = ClassifyIdentifier(str);
+    else if (type == TokenID::UNKNOWN)    type = ClassifyOperator(str);
+    sourceTokens->Append(type, static_cast<uint32_t>(start), static_cast<uint32_t>(str.size()));
 }
 
 void Lexer::Reset()
 {
-    pos = { 1, 1 };
     sourceIndex = 0;
-    if (!sourceTokens.empty())
-    {
-        sourceTokens.clear();
-        currentTokenIndex = 0;
-    }
+    currentTokenIndex = 0;
+    pulling = false;
+    // The old stream may still be referenced by an AST, so it is replaced rather than cleared
+    sourceTokens = std::make_shared<TokenStream>();
+    input = sourceTokens->source;
 }
 
-void Lexer::Consume(const TokenID tokenType)
+bool Lexer::Consume(const TokenID tokenType)
 {
-    const auto& [tok, coords, type] = sourceTokens.at(currentTokenIndex);
-    if (tokenType == type && currentTokenIndex < sourceTokens.size()) ++currentTokenIndex;
-    else throw UnexpectedTokenException(GetCurrentToken(), GetSourceLine ? GetSourceLine(coords.line) : "");
+    if (tokenType != GetCurrentTokenType() || currentTokenIndex >= sourceTokens->size()) return false;
+    // When streaming, the next batch is lexed as soon as the parser moves past the last token there is
+    if (++currentTokenIndex == sourceTokens->size()) Pull();
+    return true;
 }
 
 bool Lexer::IsQuote(const TokenID quoteType)
@@ -240,15 +651,21 @@ bool Lexer::IsQuote(const TokenID quoteType)
         Advance(prefix);
         while (Peek())
         {
+            if (engine == Engine::TableDriven)
+            {
+                // Skip the plain run up to the next quote, backslash or end at once, leaving its last character to the checks below
+                const char* const run = input.data() + sourceIndex;
+                if (const size_t length = Scan::FindAny(run, input.data() + input.size(), c, '\\') - run; length > 1) Advance(length - 1);
+            }
             // Escape Sequence within quotes - FIXME: Escape sequence is split from string itself do we care?
             if (Peek() == '\\')
             {
                 if (const size_t escape = matchEscapeSeq(); escape > 0)
                 {
-                    AddToken({ input.substr(tokenStartIndex, sourceIndex - tokenStartIndex), tokenStartPos, quoteType });
+                    AddToken(tokenStartIndex, quoteType);
                     StartToken();
                     Advance(escape);
-                    AddToken({ input.substr(tokenStartIndex, sourceIndex - tokenStartIndex), tokenStartPos, TokenID::ESCAPESEQ });
+                    AddToken(tokenStartIndex, TokenID::ESCAPESEQ);
                     StartToken();
                     continue;
                 }
@@ -257,7 +674,7 @@ bool Lexer::IsQuote(const TokenID quoteType)
                 if (!Peek(1)) break; // If string is not terminated - stop before EOF
             if (Advance() == c) break;
         }
-        AddToken({ input.substr(tokenStartIndex, sourceIndex - tokenStartIndex), tokenStartPos, quoteType });
+        AddToken(tokenStartIndex, quoteType);
         return true;
     }
     return false;
@@ -274,6 +691,13 @@ bool Lexer::IsRawString()
         const auto prefixString = input.substr(prefixStart, sourceIndex - prefixStart);
         while (Peek())
         {
+            if (engine == Engine::TableDriven)
+            {
+                // Nothing but a '"' can end the literal, skip straight to the next one
+                const char* const run = input.data() + sourceIndex;
+                Advance(Scan::FindAny(run, input.data() + input.size(), '"', '"') - run);
+                if (!Peek()) break;
+            }
             if (Advance() == '"')
             {
                 if (input[sourceIndex - 1 - prefixString.length() - 1] == ')')
@@ -283,7 +707,7 @@ bool Lexer::IsRawString()
                 }
             }
         }
-        AddToken({ input.substr(tokenStartIndex, sourceIndex - tokenStartIndex), tokenStartPos, TokenID::RAWSTR });
+        AddToken(tokenStartIndex, TokenID::RAWSTR);
         return true;
     }
     return false;
@@ -357,7 +781,7 @@ bool Lexer::IsNumber(const char current)
 
         Advance(matchTypeLiteral());
 
-        AddToken({ input.substr(tokenStartIndex, sourceIndex - tokenStartIndex), tokenStartPos, tokType });
+        AddToken(tokenStartIndex, tokType);
         return true;
     }
     return false;
@@ -372,7 +796,7 @@ bool Lexer::IsIdentifier(const char current)
     {
         StartToken();
         while (Peek() && IsValidIdentifierMid(Peek())) Advance();
-        AddToken({ input.substr(tokenStartIndex, sourceIndex - tokenStartIndex), tokenStartPos, TokenID::IDENTIFIER });
+        AddToken(tokenStartIndex, TokenID::IDENTIFIER);
         return true;
     }
     return false;
@@ -1,56 +1,139 @@
 #pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
 
-#include "Token.h"
-#include "../Util/Error.h"
+#include "TokenStream.h"
 #include "../Util/ModuleManager.h"
 
 class TextEditor;
 class Lexer : public IObserver<>
 {
+public:
+    // Both engines produce identical tokens, the table-driven one is there to be measured against
+    enum class Engine { HandWritten, TableDriven };
+    // Tokens [first, oldEnd) of the previous stream were replaced by [first, newEnd) in the last run
+    struct TokenEdit
+    {
+        TokenIndex first  = 0;
+        TokenIndex oldEnd = 0;
+        TokenIndex newEnd = 0;
+        const TokenStream* previous = nullptr;  // The stream edited, null when everything was lexed anew
+    };
 private:
+    // Furthest past the end of its token any scanner peeks
+    static constexpr size_t maxLookahead = 4;
+    // Smallest piece of text worth handing to a thread of its own
+    static constexpr size_t minChunkBytes = 256 * 1024;
+    // Tokens lexed at a time when streaming to the parser
+    static constexpr size_t pullBatch = 1024;
+
     TextEditor* editor;
 
-    std::vector<Token> sourceTokens;
-    size_t currentTokenIndex = 0;
+    std::shared_ptr<TokenStream> sourceTokens = std::make_shared<TokenStream>();
+    // Outlives the streams, so unchanged identifiers keep their atoms from one relex to the next. Cleared by a full lex,
+    // set aside while benchmarking
+    AtomTable atomTable;
+    TokenIndex currentTokenIndex = 0;
     size_t sourceIndex = 0;
     size_t tokenStartIndex = 0;
 
-    TokenCoords pos;
-    TokenCoords tokenStartPos;
+    // Set by SetSource, lexed instead of the editor's text on the next run
+    std::shared_ptr<const SourceBuffer> pendingSource;
+    // View of the source buffer owned by sourceTokens
+    std::string_view input;
+
+    size_t lexEnd = 0;  // The main loop stops at the first token starting here or after
+    size_t pullLimit = SIZE_MAX;  // or once the stream holds this many tokens
 
-    std::string input;
+    // Streaming mode: Update only lexes the first batch, the rest as the parser consumes its way to it
+    bool streaming = false;
+    bool pulling = false;  // The stream is not complete yet
 
+    // Re-lexing state, only set while Relex runs or TokenizeParallel repairs a chunk
+    std::shared_ptr<const TokenStream> previousTokens;
+    TokenIndex resyncCount = 0;    // Tokens of previousTokens that may be resynchronised with
+    size_t resyncFrom = SIZE_MAX;  // Offset in the new text where the edit ends
+    ptrdiff_t resyncShift = 0;     // Size change of the edit
+    TokenIndex resyncToken = 0;
+    TokenEdit lastEdit;
+
+    Engine engine = Engine::HandWritten;
     bool shouldRun = false;
+    size_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+    bool benchmarking = false;
+    bool deferWarnings = false;           // Collect unknown tokens' offsets in unknowns instead of logging them
+    std::vector<uint32_t> unknowns;
+
+    void Tokenize();
+    void TokenizeParallel();
+    void Pull();
+    void FinishStream();
+    void Relex(std::string text);
+    bool Resynced();
+    void TokenizeHandWritten();
+    void TokenizeTableDriven();
 
     bool IsQuote(const TokenID quoteType);
     bool IsRawString();
     bool IsNumber(const char current);
     bool IsIdentifier(const char current);
 
-    char Peek(const size_t amount = 0) const { return sourceIndex + amount >= input.size() ? 0 : input.at(sourceIndex + amount); }
-    char Advance(const size_t amount = 1);
+    char Peek(const size_t amount = 0) const { return sourceIndex + amount >= input.size() ? 0 : input[sourceIndex + amount]; }
+    // Only moves the byte offset, line/column are resolved later from the stream's line index
+    char Advance(const size_t amount = 1) { sourceIndex += amount; return input[sourceIndex - 1]; }
     void StartToken();
     void SubmitToken();
-    void AddToken(const Token& token);
+    void AddToken(const size_t start, const TokenID tokenType = TokenID::UNKNOWN);  // Token from start up to sourceIndex
+    void AddUnknownToken();
     size_t MatchStringPrefix(const char quote) const;
 public:
     Lexer(TextEditor* ed) : editor(ed) {}
     virtual ~Lexer() = default;
 
-    void Consume(const TokenID tokenType);
+    // Moves past the current token if it is of tokenType, returns whether it was
+    bool Consume(const TokenID tokenType);
+
+    void SetEngine(const Engine e) { engine = e; }
+    Engine GetEngine() const       { return engine; }
+    // Inputs of at least two minChunkBytes are split into chunks lexed on up to this many threads, with identical results
+    void SetThreadCount(const size_t n) { threadCount = std::max<size_t>(n, 1); }
+    size_t GetThreadCount() const       { return threadCount; }
+    void SetStreaming(const bool s)     { streaming = s; }
+    bool IsStreaming() const            { return streaming; }
+    // Has the next run lex this buffer, a file just opened, rather than copy the text back out of the editor.
+    // The stream lets go of a mapped file on the first run after that, once it finds the editor holding the same text
+    void SetSource(std::shared_ptr<const SourceBuffer> src) { pendingSource = std::move(src); }
+    // Lexes whatever the parser did not pull, completing the stream
+    void Drain();
+    // Lexes the editor's text, repeated up to at least minBytes, with each engine and then chunked on 1 to 16 threads,
+    // and logs their throughput
+    void Benchmark(const size_t minBytes = 8 * 1024 * 1024);
 
-    const Token& GetCurrentToken()        const { return sourceTokens.at(currentTokenIndex); }
-    std::string GetCurrentTokenVal()      const { return sourceTokens.at(currentTokenIndex).str; }
-    TokenID GetCurrentTokenType()         const { return sourceTokens.at(currentTokenIndex).type; }
-    size_t GetCurrentTokenLine()          const { return sourceTokens.at(currentTokenIndex).coords.line; }
-    size_t GetCurrentTokenCol()           const { return sourceTokens.at(currentTokenIndex).coords.line; }
-    const std::vector<Token>& GetTokens() const { return sourceTokens; }
+    Token GetCurrentToken()               const { return sourceTokens->at(currentTokenIndex); }
+    TokenIndex GetCurrentTokenIndex()     const { return currentTokenIndex; }
+    std::string_view GetCurrentTokenVal() const { return sourceTokens->GetStr(currentTokenIndex); }
+    // The parser's most frequent question, answered from the type array alone. Never past the end, ENDF is not consumed
+    TokenID GetCurrentTokenType()         const { return sourceTokens->GetType(currentTokenIndex); }
+    TokenID GetPreviousTokenType()        const { return currentTokenIndex ? sourceTokens->GetType(currentTokenIndex - 1) : TokenID::UNKNOWN; }
+    TokenCoords GetCurrentTokenCoords()   const { return sourceTokens->GetCoords(currentTokenIndex); }
+    size_t GetCurrentTokenLine()          const { return GetCurrentTokenCoords().line; }
+    size_t GetCurrentTokenCol()           const { return GetCurrentTokenCoords().col; }
+    const TokenStream& GetTokens()              { Drain(); return *sourceTokens; }
+    const TokenEdit& GetLastEdit()        const { return lastEdit; }
+    // Shared with the parser so the AST can outlive this lexer's next run
+    std::shared_ptr<const TokenStream> GetTokenStream() const { return sourceTokens; }
 
-    bool Done()       const { return sourceTokens.empty() || GetCurrentTokenType() == TokenID::ENDF; }
-    bool HasTokens()  const { return !sourceTokens.empty(); }
+    bool Done()       const { return sourceTokens->empty() || GetCurrentTokenType() == TokenID::ENDF; }
+    bool HasTokens()  const { return !sourceTokens->empty(); }
     void ResetIndex()       { currentTokenIndex = 0; }
+    // Picks up from token i of a complete stream, for the parser to go over part of it again
+    void Seek(const TokenIndex i) { currentTokenIndex = i; }
 
     // Inherited via IObserver
     virtual bool ShouldRun() const override { return shouldRun; }
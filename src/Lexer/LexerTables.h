@@ -0,0 +1,113 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+#include "Token.h"
+
+// Character classes used by the table-driven lexer. Every byte maps to exactly one class through charClasses
+enum class CharClass : uint8_t
+{
+    OTHER,      // Cannot start any token, lexed as unknown
+    END,        // '\0' - stops comments and literals just like the end of the input does
+    SPACE,      // ' ', '\t', '\v', '\f', '\r'
+    NEWLINE,    // '\n'
+    LETTER,     // Identifier characters, other than the prefixes below
+    PREFIX,     // 'L', 'u', 'U', 'R' can also start a string or raw string literal
+    DIGIT,
+    DOT,
+    QUOTE,      // '\'' and '"'
+    SLASH,      // Division or the start of a comment
+    // Operator characters get a class each, which operator they begin depends on what follows them
+    LT, GT, PLUS, MINUS, AMP, PIPE, EQUAL, STAR, BANG, CARET, PERCENT,
+    PUNCT,      // Single character terminals and operators, never followed by anything
+    COUNT
+};
+
+constexpr size_t charClassCount = static_cast<size_t>(CharClass::COUNT);
+
+constexpr std::array<CharClass, 256> MakeCharClasses()
+{
+    std::array<CharClass, 256> classes{};
+    for (auto& c : classes) c = CharClass::OTHER;
+    for (int c = 'a'; c <= 'z'; ++c) classes[c] = CharClass::LETTER;
+    for (int c = 'A'; c <= 'Z'; ++c) classes[c] = CharClass::LETTER;
+    for (int c = '0'; c <= '9'; ++c) classes[c] = CharClass::DIGIT;
+    classes['_']  = classes['$'] = CharClass::LETTER;
+    classes['L']  = classes['u'] = classes['U'] = classes['R'] = CharClass::PREFIX;
+    classes['\0'] = CharClass::END;
+    classes[' ']  = classes['\t'] = classes['\v'] = classes['\f'] = classes['\r'] = CharClass::SPACE;
+    classes['\n'] = CharClass::NEWLINE;
+    classes['.']  = CharClass::DOT;
+    classes['\''] = classes['"'] = CharClass::QUOTE;
+    classes['/']  = CharClass::SLASH;
+    classes['<']  = CharClass::LT;
+    classes['>']  = CharClass::GT;
+    classes['+']  = CharClass::PLUS;
+    classes['-']  = CharClass::MINUS;
+    classes['&']  = CharClass::AMP;
+    classes['|']  = CharClass::PIPE;
+    classes['=']  = CharClass::EQUAL;
+    classes['*']  = CharClass::STAR;
+    classes['!']  = CharClass::BANG;
+    classes['^']  = CharClass::CARET;
+    classes['%']  = CharClass::PERCENT;
+    for (const char c : { '[', ']', '{', '}', '(', ')', ';', ',', '?', '~' }) classes[static_cast<unsigned char>(c)] = CharClass::PUNCT;
+    return classes;
+}
+
+inline constexpr std::array<CharClass, 256> charClasses = MakeCharClasses();
+
+constexpr CharClass ClassOf(const char c) { return charClasses[static_cast<unsigned char>(c)]; }
+constexpr bool IsOperatorClass(const CharClass c) { return c >= CharClass::SLASH && c <= CharClass::PUNCT; }
+constexpr bool IsIdentifierClass(const CharClass c) { return c == CharClass::LETTER || c == CharClass::PREFIX || c == CharClass::DIGIT; }
+constexpr bool IsSpaceClass(const CharClass c) { return c == CharClass::SPACE || c == CharClass::NEWLINE; }
+
+// Maximal munch DFA over the operator lexemes, built from operatorLexemes at compile time as a trie on
+// character classes. It only decides where an operator ends, the lexeme itself is then classified
+// by the operator table. Lexemes made of non-operator characters ('.', quotes, '\\') are left out,
+// the lexer reaches those through other paths.
+struct OperatorDfa
+{
+    static constexpr size_t  maxStates = 64;
+    static constexpr uint8_t dead      = 0xFF;
+    static constexpr uint8_t start     = 0;
+
+    uint8_t next[maxStates][charClassCount] = {};
+    bool accepting[maxStates] = {};
+    size_t stateCount = 1;
+
+    constexpr OperatorDfa()
+    {
+        for (auto& row : next) for (auto& to : row) to = dead;
+        for (const auto& [str, type] : operatorLexemes)
+        {
+            bool isOperator = true;
+            for (const char c : str) isOperator = isOperator && IsOperatorClass(ClassOf(c));
+            if (!isOperator) continue;
+
+            uint8_t state = start;
+            for (const char c : str)
+            {
+                uint8_t& to = next[state][static_cast<size_t>(ClassOf(c))];
+                if (to == dead) to = static_cast<uint8_t>(stateCount++);
+                state = to;
+            }
+            accepting[state] = true;
+        }
+    }
+
+    // Length of the longest operator at the start of str, which must be null terminated
+    constexpr size_t Match(const char* str) const
+    {
+        size_t length = 0;
+        uint8_t state = start;
+        for (size_t i = 0; (state = next[state][static_cast<size_t>(ClassOf(str[i]))]) != dead; ++i)
+            if (accepting[state]) length = i + 1;
+        return length;
+    }
+};
+
+inline constexpr OperatorDfa operatorDfa;
+
+static_assert(operatorDfa.stateCount <= OperatorDfa::maxStates);
+static_assert(operatorDfa.Match(">>=1") == 3 && operatorDfa.Match("&&=") == 2 && operatorDfa.Match("+-") == 1);
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include <cstdint>
+
+#include "SimdScan.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SCAN_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SCAN_TARGET_AVX2
+#else
+#define SCAN_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SCAN_SSE2
+#endif
+#endif
+
+namespace Scan
+{
+    // What ends a scan. For the Not* kinds the scan runs while characters are in the set
+    enum class Stop { NotSpace, NotIdentifier, LineEnd, AnyOf };
+
+    static uint32_t CountTrailingZeros(const uint32_t mask)
+    {
+#ifdef _MSC_VER
+        unsigned long i;
+        _BitScanForward(&i, mask);
+        return i;
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+
+//--------------------------------Scalar----------------------------------------
+//------------------------------------------------------------------------------
+    template<Stop S>
+    static bool IsStop(const char c, const char a, const char b)
+    {
+        const unsigned char u = static_cast<unsigned char>(c);
+        if constexpr (S == Stop::NotSpace)      return !(u == ' ' || (u >= '\t' && u <= '\r'));
+        if constexpr (S == Stop::NotIdentifier) return !(((u | 0x20) >= 'a' && (u | 0x20) <= 'z') || (u >= '0' && u <= '9') || u == '_' || u == '$');
+        if constexpr (S == Stop::LineEnd)       return u == '\n' || u == '\0';
+        if constexpr (S == Stop::AnyOf)         return c == a || c == b || c == '\0';
+    }
+
+    template<Stop S>
+    static const char* FindScalar(const char* p, const char* end, const char a, const char b)
+    {
+        while (p < end && !IsStop<S>(*p, a, b)) ++p;
+        return p;
+    }
+
+//---------------------------------SSE2-----------------------------------------
+//------------------------------------------------------------------------------
+#ifdef SCAN_SSE2
+    template<Stop S>
+    static const char* FindSSE2(const char* p, const char* end, const char a, const char b)
+    {
+        for (; end - p >= 16; p += 16)
+        {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            __m128i match;
+            if constexpr (S == Stop::NotSpace)
+                match = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                                     _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('\t' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('\r' + 1))));
+            if constexpr (S == Stop::NotIdentifier)
+            {
+                const __m128i lower  = _mm_or_si128(v, _mm_set1_epi8(0x20));
+                const __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+                const __m128i digit  = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+                match = _mm_or_si128(_mm_or_si128(letter, digit), _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('_')), _mm_cmpeq_epi8(v, _mm_set1_epi8('$'))));
+            }
+            if constexpr (S == Stop::LineEnd)
+                match = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_setzero_si128()));
+            if constexpr (S == Stop::AnyOf)
+                match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(a)), _mm_cmpeq_epi8(v, _mm_set1_epi8(b))), _mm_cmpeq_epi8(v, _mm_setzero_si128()));
+
+            uint32_t stop = static_cast<uint32_t>(_mm_movemask_epi8(match));
+            if constexpr (S == Stop::NotSpace || S == Stop::NotIdentifier) stop ^= 0xFFFFu;
+            if (stop) return p + CountTrailingZeros(stop);
+        }
+        return FindScalar<S>(p, end, a, b);
+    }
+
+#endif // SCAN_SSE2
+
+//---------------------------------AVX2-----------------------------------------
+//------------------------------------------------------------------------------
+#ifdef SCAN_X86
+    template<Stop S>
+    SCAN_TARGET_AVX2 static const char* FindAVX2(const char* p, const char* end, const char a, const char b)
+    {
+        for (; end - p >= 32; p += 32)
+        {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            __m256i match;
+            if constexpr (S == Stop::NotSpace)
+                match = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                                        _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('\t' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), v)));
+            if constexpr (S == Stop::NotIdentifier)
+            {
+                const __m256i lower  = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+                const __m256i letter = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+                const __m256i digit  = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), v));
+                match = _mm256_or_si256(_mm256_or_si256(letter, digit), _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('$'))));
+            }
+            if constexpr (S == Stop::LineEnd)
+                match = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+            if constexpr (S == Stop::AnyOf)
+                match = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(a)), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(b))), _mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+
+            uint32_t stop = static_cast<uint32_t>(_mm256_movemask_epi8(match));
+            if constexpr (S == Stop::NotSpace || S == Stop::NotIdentifier) stop = ~stop;
+            if (stop) return p + CountTrailingZeros(stop);
+        }
+        return FindScalar<S>(p, end, a, b);
+    }
+
+#endif // SCAN_X86
+
+//-------------------------------Dispatch---------------------------------------
+//------------------------------------------------------------------------------
+    Level GetSupportedLevel()
+    {
+        static const Level supported = []() {
+#ifdef SCAN_X86
+#ifdef _MSC_VER
+            int info[4];
+            __cpuid(info, 0);
+            const int maxLeaf = info[0];
+            __cpuid(info, 1);
+            // AVX state must also be enabled by the OS (OSXSAVE set and XMM/YMM state saved)
+            const bool osAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+            if (maxLeaf >= 7 && osAvx)
+            {
+                __cpuidex(info, 7, 0);
+                if (info[1] & (1 << 5)) return Level::AVX2;
+            }
+#else
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) return Level::AVX2;
+#endif
+#endif
+#ifdef SCAN_SSE2
+            return Level::SSE2;
+#else
+            return Level::Scalar;
+#endif
+        }();
+        return supported;
+    }
+
+    static Level level = GetSupportedLevel();
+
+    Level GetLevel() { return level; }
+    void SetLevel(const Level lvl) { level = lvl > GetSupportedLevel() ? GetSupportedLevel() : lvl; }
+
+    const char* GetLevelName(const Level lvl)
+    {
+        switch (lvl)
+        {
+        case Level::AVX2: return "AVX2";
+        case Level::SSE2: return "SSE2";
+        default:          return "Scalar";
+        }
+    }
+
+    template<Stop S>
+    static const char* Find(const char* p, const char* end, const char a = '\0', const char b = '\0')
+    {
+        switch (level)
+        {
+#ifdef SCAN_X86
+        case Level::AVX2: return FindAVX2<S>(p, end, a, b);
+#endif
+#ifdef SCAN_SSE2
+        case Level::SSE2: return FindSSE2<S>(p, end, a, b);
+#endif
+        default:          return FindScalar<S>(p, end, a, b);
+        }
+    }
+
+    const char* SkipSpaces(const char* p, const char* end)                           { return Find<Stop::NotSpace>(p, end); }
+    const char* SkipIdentifier(const char* p, const char* end)                       { return Find<Stop::NotIdentifier>(p, end); }
+    const char* FindLineEnd(const char* p, const char* end)                          { return Find<Stop::LineEnd>(p, end); }
+    const char* FindAny(const char* p, const char* end, const char a, const char b)  { return Find<Stop::AnyOf>(p, end, a, b); }
+}
\ No newline at end of file
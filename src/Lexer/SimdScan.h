@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+
+// Vectorised scanning kernels for the table-driven lexer. Each has an AVX2, an SSE2 and a scalar
+// version, the best one the CPU supports is picked once at startup (or forced through SetLevel).
+// All of them stop at 'end' at the latest and never read past it.
+namespace Scan
+{
+    enum class Level { Scalar, SSE2, AVX2 };
+
+    Level GetLevel();
+    Level GetSupportedLevel();
+    void SetLevel(const Level lvl);  // Clamped to what the CPU supports
+    const char* GetLevelName(const Level lvl);
+
+    // First character that is not whitespace (' ', '\t', '\n', '\v', '\f', '\r')
+    const char* SkipSpaces(const char* p, const char* end);
+    // First character that is not part of an identifier ([A-Za-z0-9_$])
+    const char* SkipIdentifier(const char* p, const char* end);
+    // First '\n' or '\0'
+    const char* FindLineEnd(const char* p, const char* end);
+    // First a, b or '\0'
+    const char* FindAny(const char* p, const char* end, const char a, const char b);
+}
\ No newline at end of file
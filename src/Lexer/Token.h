@@ -1,5 +1,8 @@
 #pragma once
-#include <unordered_map>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
 
 enum class TokenID
 {
@@ -77,7 +80,82 @@ enum class TokenID
     UNKNOWN
 };
 
-static std::unordered_map<std::string, TokenID> tokens =
+// A lexeme with a dedicated TokenID
+struct Lexeme
+{
+    std::string_view str;
+    TokenID type;
+};
+
+// Compile-time perfect hash over a fixed set of lexemes. The constructor searches for a seed that
+// sends every lexeme to its own slot, so a lookup is a single multiply, load and compare.
+// Being constexpr, the whole search happens during compilation and the table is immutable after.
+template<size_t N, size_t Bits>
+class LexemeTable
+{
+private:
+    static constexpr size_t  slotCount = size_t(1) << Bits;
+    static constexpr uint8_t emptySlot = 0xFF;
+    static_assert(N < emptySlot, "Lexeme indices must fit in a slot");
+
+    Lexeme lexemes[N] = {};
+    uint8_t slots[slotCount] = {};
+    uint64_t seed = 0;
+    size_t maxLength = 0;
+
+    static constexpr uint64_t Key(const std::string_view str)
+    {
+        uint64_t key = str.size();
+        for (const char c : str) key = key * 257 + static_cast<unsigned char>(c);
+        return key;
+    }
+    static constexpr size_t Slot(const std::string_view str, const uint64_t s) { return static_cast<size_t>(((Key(str) ^ s) * 0x9E3779B97F4A7C15ull) >> (64 - Bits)); }
+public:
+    constexpr LexemeTable(const Lexeme (&set)[N])
+    {
+        for (size_t i = 0; i < N; ++i)
+        {
+            lexemes[i] = set[i];
+            if (set[i].str.size() > maxLength) maxLength = set[i].str.size();
+        }
+        for (uint64_t s = 0; ; ++s)
+        {
+            bool collision = false;
+            for (auto& slot : slots) slot = emptySlot;
+            for (size_t i = 0; i < N && !collision; ++i)
+            {
+                uint8_t& slot = slots[Slot(lexemes[i].str, s)];
+                if (slot != emptySlot) collision = true;
+                else slot = static_cast<uint8_t>(i);
+            }
+            if (!collision) { seed = s; return; }
+        }
+    }
+
+    // The lexeme's TokenID, or fallback if it is not part of the set
+    constexpr TokenID Find(const std::string_view str, const TokenID fallback) const
+    {
+        if (str.empty() || str.size() > maxLength) return fallback;
+        const uint8_t i = slots[Slot(str, seed)];
+        return i != emptySlot && lexemes[i].str == str ? lexemes[i].type : fallback;
+    }
+};
+
+inline constexpr Lexeme keywordLexemes[] =
+{
+//----------Reserved Keywords--------------------
+//-----------------------------------------------
+    { "if"     , TokenID::IF         },
+    { "else"   , TokenID::ELSE       },
+    { "while"  , TokenID::WHILE      },
+    { "do"     , TokenID::DO         },
+    { "int"    , TokenID::INT_TYPE   },
+    { "float"  , TokenID::FLOAT_TYPE },
+    { "return" , TokenID::RET        },
+    { "main"   , TokenID::MAIN       },               // MAIN IS NOT A RESERVED WORD - ITS AN IDENTIFIER THAT CAN ONLY EXIST ONE OF FOR FUNCTIONS - HACK FOR NOW
+};
+
+inline constexpr Lexeme operatorLexemes[] =
 {
 //----------Arithmetic Operators-----------------
 //-----------------------------------------------
@@ -124,16 +202,6 @@ static std::unordered_map<std::string, TokenID> tokens =
     { ">>="    , TokenID::SHR_ASGN   },
     { "|="     , TokenID::B_OR_ASGN  },
     { "&="     , TokenID::B_AND_ASGN },
-//----------Reserved Keywords--------------------
-//-----------------------------------------------
-    { "if"     , TokenID::IF         },
-    { "else"   , TokenID::ELSE       },
-    { "while"  , TokenID::WHILE      },
-    { "do"     , TokenID::DO         },
-    { "int"    , TokenID::INT_TYPE   },
-    { "float"  , TokenID::FLOAT_TYPE },
-    { "return" , TokenID::RET        },
-    { "main"   , TokenID::MAIN       },               // MAIN IS NOT A RESERVED WORD - ITS AN IDENTIFIER THAT CAN ONLY EXIST ONE OF FOR FUNCTIONS - HACK FOR NOW
 //-------------Terminals-------------------------
 //-----------------------------------------------
     { "("      , TokenID::LPAR       },
@@ -147,18 +215,29 @@ static std::unordered_map<std::string, TokenID> tokens =
 //-----------------------------------------------
     { "'"      , TokenID::S_QUOTE    },
     { "\""     , TokenID::D_QUOTE    },
-    { "R"      , TokenID::RAWSTR     },
     { "\\"     , TokenID::ESCAPESEQ  },
 //--------Miscellaneous Operators----------------
 //-----------------------------------------------
     { ","      , TokenID::COMMA      },
     { "?"      , TokenID::TERNARY    },
-    { "."      , TokenID::DOT        },  
+    { "."      , TokenID::DOT        },
 //-----------Miscellaneous-----------------------
 //-----------------------------------------------
     { "\032"   , TokenID::ENDF       }
 };
 
+inline constexpr LexemeTable<std::size(keywordLexemes), 4>  keywordTable(keywordLexemes);
+inline constexpr LexemeTable<std::size(operatorLexemes), 8> operatorTable(operatorLexemes);
+
+// Identifiers that are reserved keywords get the keyword's TokenID, the rest stay identifiers
+constexpr TokenID ClassifyIdentifier(const std::string_view str) { return keywordTable.Find(str, TokenID::IDENTIFIER); }
+// Operators, terminals and stray characters. Anything outside the fixed set is unknown
+constexpr TokenID ClassifyOperator(const std::string_view str)   { return operatorTable.Find(str, TokenID::UNKNOWN); }
+
+static_assert(ClassifyIdentifier("while") == TokenID::WHILE && ClassifyIdentifier("whilst") == TokenID::IDENTIFIER);
+static_assert(ClassifyOperator(">>=") == TokenID::SHR_ASGN && ClassifyOperator("@") == TokenID::UNKNOWN);
+
+// Resolved on demand by TokenStream::Locate, tokens themselves only know their byte offset
 struct TokenCoords
 {
     size_t line = 1;
@@ -167,7 +246,10 @@ struct TokenCoords
 
 struct Token
 {
-    const std::string str;
-    const TokenCoords coords;
+    std::string_view str;  // View into the source buffer of the TokenStream that owns this token
+    uint32_t offset = 0;   // Byte offset of str in that buffer
     TokenID type = TokenID::UNKNOWN;
-};
\ No newline at end of file
+};
+
+// Position of a token in its TokenStream. AST nodes refer to tokens through these rather than copies
+using TokenIndex = uint32_t;
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "TokenStream.h"
+
+void TokenStream::BuildLineIndex() const
+{
+    const char* const begin = source.data();
+    const char* const end = begin + source.size();
+    lineStarts.push_back(0);
+    for (const char* nl = begin; (nl = static_cast<const char*>(std::memchr(nl, '\n', end - nl))) != nullptr; ++nl)
+        lineStarts.push_back(static_cast<uint32_t>(nl + 1 - begin));
+}
+
+const std::vector<uint32_t>& TokenStream::GetLineStarts() const
+{
+    std::call_once(lineIndexBuilt, [this]() { BuildLineIndex(); });
+    return lineStarts;
+}
+
+void TokenStream::Append(const TokenID type, const uint32_t offset, const uint32_t length)
+{
+    types.push_back(static_cast<uint8_t>(type));
+    offsets.push_back(offset);
+    lengths.push_back(length);
+}
+
+void TokenStream::IndexIdentifiers()
+{
+    identifiers.assign(types.size() / 64 + 1, 0);
+    identifiersBefore.assign(identifiers.size(), 0);
+    uint32_t count = 0;
+    for (size_t word = 0; word < identifiers.size(); ++word)
+    {
+        identifiersBefore[word] = count;
+        const size_t end = std::min(types.size(), word * 64 + 64);
+        for (size_t i = word * 64; i < end; ++i)
+            if (types[i] == static_cast<uint8_t>(TokenID::IDENTIFIER)) identifiers[word] |= uint64_t(1) << (i % 64);
+        count += static_cast<uint32_t>(std::bitset<64>(identifiers[word]).count());
+    }
+}
+
+void TokenStream::Seal()
+{
+    types.shrink_to_fit();
+    offsets.shrink_to_fit();
+    lengths.shrink_to_fit();
+    atoms.shrink_to_fit();
+}
+
+Token TokenStream::at(const TokenIndex i) const
+{
+    if (i >= types.size()) throw std::out_of_range("TokenStream::at");
+    return (*this)[i];
+}
+
+std::string_view TokenStream::GetStr(const TokenIndex i) const
+{
+    // The end of file token is the only one not taken from the source
+    if (lengths[i] == 0 && GetType(i) == TokenID::ENDF) return "EOF";
+    return std::string_view(source).substr(offsets[i], lengths[i]);
+}
+
+double TokenStream::GetBytesPerToken() const
+{
+    if (types.empty()) return 0.0;
+    const size_t bytes = types.capacity() * sizeof(uint8_t) + (offsets.capacity() + lengths.capacity()) * sizeof(uint32_t) + atoms.capacity() * sizeof(Atom) +
+        identifiers.capacity() * sizeof(uint64_t) + identifiersBefore.capacity() * sizeof(uint32_t);
+    return static_cast<double>(bytes) / types.size();
+}
+
+std::string_view TokenStream::GetLine(const size_t line) const
+{
+    const auto& starts = GetLineStarts();
+    if (line == 0 || line > starts.size()) return "";
+    const size_t begin = starts[line - 1];
+    size_t end = line < starts.size() ? starts[line] - 1 : source.size();
+    if (end > begin && source[end - 1] == '\r') --end;
+    return source.substr(begin, end - begin);
+}
+
+TokenCoords TokenStream::Locate(const uint32_t offset) const
+{
+    // The last line starting at or before offset, the index always begins with 0 so there is one
+    const auto& starts = GetLineStarts();
+    const auto line = std::upper_bound(starts.begin(), starts.end(), offset) - 1;
+    TokenCoords coords { static_cast<size_t>(line - starts.begin()) + 1, 1 };
+    for (uint32_t i = *line; i < offset && i < source.size(); ++i) coords.col += source[i] == '\t' ? tabSize : 1;
+    return coords;
+}
\ No newline at end of file
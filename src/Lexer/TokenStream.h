@@ -0,0 +1,84 @@
+#pragma once
+#include <bitset>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "AtomTable.h"
+#include "Token.h"
+#include "../Util/SourceBuffer.h"
+
+// The output of a single lexer run. Shares ownership of the source buffer that every token views into,
+// so it is never modified once published - anyone holding on to it (the parser's AST)
+// can keep referring to its tokens by index, even after the lexer has moved on.
+//
+static_assert(static_cast<int>(TokenID::UNKNOWN) <= UINT8_MAX, "Token types are stored in a byte each");
+
+// Tokens are kept as a struct of arrays, 9 bytes each: the parser mostly asks for types,
+// so a lookahead only touches the type array. Token values are put together on access.
+// Identifiers also get the atom of their spelling, from the lexer's AtomTable, once the stream is finished. Only they
+// take room for one: an identifier's atom is found by how many identifiers come before it, counted from a bit per token
+class TokenStream
+{
+private:
+    const std::shared_ptr<const SourceBuffer> buffer;
+    const std::string_view source = "";  // buffer's text, '\0' terminated
+    std::vector<uint8_t>  types;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> lengths;
+    std::vector<Atom>     atoms;              // Of the identifiers alone, in order
+    std::vector<uint64_t> identifiers;        // Bit i % 64 of word i / 64 is set if token i is an identifier
+    std::vector<uint32_t> identifiersBefore;  // Identifiers in the words before each word of identifiers
+    Atom atomEnd = AtomTable::none + 1;
+    size_t tabSize = 4;
+
+    // Offset of the first character of every line, built the first time coordinates or lines are asked for
+    // (diagnostics, the token table) - std::call_once keeps that safe from any thread, it never changes after
+    mutable std::vector<uint32_t> lineStarts;
+    mutable std::once_flag lineIndexBuilt;
+    friend class Lexer;
+
+    void BuildLineIndex() const;
+    const std::vector<uint32_t>& GetLineStarts() const;
+    void Append(const TokenID type, const uint32_t offset, const uint32_t length);
+    void IndexIdentifiers();  // Sets up identifiers and identifiersBefore, once every token is in
+    void Seal();              // Drops the spare capacity once the lexer is done
+    // Identifiers among tokens [0, i)
+    uint32_t CountIdentifiers(const TokenIndex i) const
+    {
+        const uint64_t below = identifiers[i / 64] & ((uint64_t(1) << (i % 64)) - 1);
+        return identifiersBefore[i / 64] + static_cast<uint32_t>(std::bitset<64>(below).count());
+    }
+public:
+    TokenStream() = default;
+    TokenStream(std::shared_ptr<const SourceBuffer> src, const size_t tabs) : buffer(std::move(src)), source(buffer->GetText()), tabSize(tabs) {}
+    TokenStream(std::string src, const size_t tabs) : TokenStream(std::make_shared<const SourceBuffer>(std::move(src)), tabs) {}
+
+    TokenID GetType(const TokenIndex i)            const { return static_cast<TokenID>(types[i]); }
+    uint32_t GetOffset(const TokenIndex i)         const { return offsets[i]; }
+    std::string_view GetStr(const TokenIndex i)    const;
+    Token operator[](const TokenIndex i)           const { return { GetStr(i), offsets[i], GetType(i) }; }
+    Token at(const TokenIndex i)                   const;
+    Token back()                                   const { return (*this)[static_cast<TokenIndex>(types.size() - 1)]; }
+    size_t size()                                  const { return types.size(); }
+    bool empty()                                   const { return types.empty(); }
+
+    // Same atom, same spelling: identifiers compare by these in O(1), and index tables of GetAtomEnd() entries.
+    // Token i has to be an identifier
+    Atom GetAtom(const TokenIndex i)               const { return atoms[CountIdentifiers(i)]; }
+    Atom GetAtomEnd()                              const { return atomEnd; }
+
+    std::string_view GetSource()                   const { return source; }
+    // Bytes held per token by the arrays above, line index not included
+    double GetBytesPerToken()                      const;
+
+    // Line (1-based) and tab expanded column of a byte offset, found by binary search over the line starts
+    TokenCoords Locate(const uint32_t offset)      const;
+    TokenCoords GetCoords(const TokenIndex i)      const { return Locate(offsets[i]); }
+    size_t GetLineCount()                          const { return GetLineStarts().size(); }
+    uint32_t GetLineStart(const size_t line)       const { return GetLineStarts()[line - 1]; }
+    // Text of a line (1-based) without its line ending, sliced out of the source. Empty past the last line
+    std::string_view GetLine(const size_t line)    const;
+};
\ No newline at end of file
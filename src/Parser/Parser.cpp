@@ -1,3 +1,8 @@
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <initializer_list>
+
 #include "Parser.h"
 #include "../Util/Logger.h"
 
@@ -5,23 +10,61 @@ void Parser::Update()
 {
     if (!shouldRun) return;
     failState = false;
-    try 
-    { 
-        // Don't bother creating the AST if there are no tokens
-        root = lexer->HasTokens() ? ParseProgram() : UnqPtr<ASTNode>();
+    panicking = false;
+    diagnostics.Clear();
+    ast.changed.clear();
+
+    // The AST's nodes index into the stream they were parsed from, so it is kept alongside them
+    const TokenStream* parsedFrom = ast.tokens.get();
+    ast.tokens = lexer->GetTokenStream();
+    if (Reparse(lexer->GetLastEdit(), parsedFrom))
+    {
         shouldRun = false;
+        NotifyObservers(Notify::ASTChanged);
+        lexer->ResetIndex();
+        return;
     }
-    catch (const UnexpectedTokenException& ex)
-    { 
+
+    // The previous tree goes in one go, its nodes are overwritten by the new one's
+    ast.root = nullptr;
+    ast.arena.Reset();
+    ast.flat.Clear();
+    // Don't bother creating the AST if there are no tokens
+    ast.root = lexer->HasTokens() ? ParseProgram() : nullptr;
+    fullParseNodes = ast.arena.GetNodeCount();
+    if (ast.root) ast.changed.push_back(ast.root);
+
+    if (diagnostics.empty()) shouldRun = false;
+    else
+    {
+        // Parsing carried on past every error to find the rest, but the tree it built is not a program
         failState = true;
-        root.reset();
-        Logger::Error("{}\n", ex.what());
+        ast.root = nullptr;
+        ast.arena.Reset();
+        ast.changed.clear();
+        lexer->Drain();
+        diagnostics.Log(*ast.tokens);
     }
 
-    if (!failState && root) Logger::Info("Parsing Successful, AST Built\n");
+    if (!failState && ast.root)
+    {
+        Logger::Info("Parsing Successful, AST Built\n");
+        Logger::Debug("AST: {} nodes in {} arena block(s), {:.1f} nodes per block, {:.1f} bytes per node\n",
+            ast.arena.GetNodeCount(), ast.arena.GetBlockCount(), ast.arena.GetNodesPerBlock(), ast.arena.GetBytesPerNode());
+        if (flat)
+        {
+            ast.flat.Build(*ast.root);
+            ast.root = nullptr;
+            ast.arena.Reset();
+            ast.changed.clear();
+            Logger::Debug("Flat AST: {} nodes, {:.1f} bytes per node\n", ast.flat.size(), ast.flat.GetBytesPerNode());
+        }
+    }
     // Somewhere, somehow not all tokens were processed.
     if (!lexer->Done()) 
         Logger::Error("Unproccessed tokens left starting at {}:{}\n", lexer->GetCurrentTokenLine(), lexer->GetCurrentTokenCol());
+    // A streaming lexer stops where the parser did, the AST's observers get the whole stream
+    lexer->Drain();
 
     // AST was either reset or recreated, notify any observers that it has changed
     NotifyObservers(Notify::ASTChanged);
@@ -34,124 +77,392 @@ void Parser::Update()
 void Parser::Reset()
 {
     failState = false;
-    root.reset();
+    ast.root = nullptr;
+    ast.arena.Reset();
+    ast.flat.Clear();
+    ast.tokens.reset();
+    ast.changed.clear();
+    fullParseNodes = 0;
     NotifyObservers(Notify::ASTChanged);
 }
 
-// FACTOR := (ADD | SUB ) FACTOR | INTEGER | IDENTIFIER | LPAR EXPRESSION RPAR
-UnqPtr<ASTNode> Parser::ParseFactor()
+void Parser::BenchmarkMemory() const
 {
-    const auto&[tokValue, coords, tokType] = lexer->GetCurrentToken();
-    const auto& currentToken = lexer->GetCurrentToken();
-    // Just a unary operator (+ or -) before a literal or identifier
-    if (tokType == TokenID::ADD || tokType == TokenID::SUB)
-    {
-        lexer->Consume(tokType);
-        return std::make_unique<UnaryOperationNode>(currentToken, ParseFactor());
-    }
-    else if (tokType == TokenID::INT_LITERAL)
-    {
-        lexer->Consume(TokenID::INT_LITERAL);
-        return std::make_unique<IntegerNode>(tokValue);
-    }
-    else if (tokType == TokenID::IDENTIFIER)
+    Logger::Info("AST node sizes: Integer {}, Identifier {}, UnaryOperation {}, BinaryOperation {}, If {}, IfStatement {}, While {}, "
+        "CompoundStatement {}, DeclareStatement {}, FlatNode {} bytes\n",
+        sizeof(IntegerNode), sizeof(IdentifierNode), sizeof(UnaryOperationNode), sizeof(BinaryOperationNode), sizeof(IfNode), sizeof(IfStatementNode),
+        sizeof(WhileNode), sizeof(CompoundStatementNode), sizeof(DeclareStatementNode), sizeof(FlatNode));
+
+    if (ast.root)
     {
-        lexer->Consume(TokenID::IDENTIFIER);
-        return std::make_unique<IdentifierNode>(currentToken);
+        // Statement lists of compound statements and chained ifs live outside the arena and are not counted
+        FlatAST flattened;
+        flattened.Build(*ast.root);
+        Logger::Info("Current AST: {} nodes, {:.1f} bytes per node in the arena, {:.1f} as a FlatAST\n",
+            ast.arena.GetNodeCount(), ast.arena.GetBytesPerNode(), flattened.GetBytesPerNode());
     }
-    else if (tokType == TokenID::LPAR)
+    else if (!ast.flat.empty())
+        Logger::Info("Current AST: {} nodes, {:.1f} bytes per node as a FlatAST\n", ast.flat.size(), ast.flat.GetBytesPerNode());
+    else Logger::Warn("No AST to measure\n");
+}
+
+// Small pass for BenchmarkDispatch, visited through Dispatch
+struct DispatchedCounter
+{
+    int64_t sum = 0;
+
+    void Visit(IntegerNode& n)           { sum += n.value; }
+    void Visit(IdentifierNode& n)        { sum += n.token; }
+    void Visit(UnaryOperationNode& n)    { sum += n.op; }
+    void Visit(BinaryOperationNode& n)   { sum += n.op; }
+    void Visit(ConditionNode& n)         { sum -= n.op; }
+    void Visit(IfNode& n)                {}
+    void Visit(IfStatementNode& n)       {}
+    void Visit(WhileNode& n)             {}
+    void Visit(DoWhileNode& n)           {}
+    void Visit(CompoundStatementNode& n) {}
+    void Visit(StatementBlockNode& n)    {}
+    void Visit(DeclareStatementNode& n)  {}
+    void Visit(DeclareAssignNode& n)     {}
+    void Visit(AssignStatementNode& n)   {}
+    void Visit(ReturnStatementNode& n)   {}
+    void Visit(EmptyStatementNode& n)    {}
+};
+
+// The same pass, visited through Accept
+class VirtualCounter : public ASTNodeVisitor
+{
+public:
+    DispatchedCounter counter;
+
+    void Visit(IntegerNode& n)           override { counter.Visit(n); }
+    void Visit(IdentifierNode& n)        override { counter.Visit(n); }
+    void Visit(UnaryOperationNode& n)    override { counter.Visit(n); }
+    void Visit(BinaryOperationNode& n)   override { counter.Visit(n); }
+    void Visit(ConditionNode& n)         override { counter.Visit(n); }
+    void Visit(IfNode& n)                override { counter.Visit(n); }
+    void Visit(IfStatementNode& n)       override { counter.Visit(n); }
+    void Visit(WhileNode& n)             override { counter.Visit(n); }
+    void Visit(DoWhileNode& n)           override { counter.Visit(n); }
+    void Visit(CompoundStatementNode& n) override { counter.Visit(n); }
+    void Visit(StatementBlockNode& n)    override { counter.Visit(n); }
+    void Visit(DeclareStatementNode& n)  override { counter.Visit(n); }
+    void Visit(DeclareAssignNode& n)     override { counter.Visit(n); }
+    void Visit(AssignStatementNode& n)   override { counter.Visit(n); }
+    void Visit(ReturnStatementNode& n)   override { counter.Visit(n); }
+    void Visit(EmptyStatementNode& n)    override { counter.Visit(n); }
+};
+
+void Parser::BenchmarkDispatch(const size_t nodeCount) const
+{
+    // A balanced expression tree, built bottom up: integer and identifier leaves, paired up by
+    // binary operations and conditions until a single root is left
+    ASTArena arena;
+    std::vector<ASTNode*> nodes, level, next;
+    nodes.reserve(nodeCount + 1);
+    for (size_t i = 0; i < nodeCount / 2 + 1; ++i)
+        level.push_back(i % 2 ? static_cast<ASTNode*>(arena.Make<IdentifierNode>(static_cast<TokenIndex>(i))) : arena.Make<IntegerNode>(7));
+    nodes = level;
+    while (level.size() > 1)
     {
-        lexer->Consume(TokenID::LPAR);
-        UnqPtr<ASTNode> node = parsingCond ? ParseCond() : ParseExpr();
-        lexer->Consume(TokenID::RPAR);
-        return node;
+        next.clear();
+        for (size_t i = 0; i + 1 < level.size(); i += 2)
+        {
+            ASTNode* op = i % 4 ? static_cast<ASTNode*>(arena.Make<ConditionNode>(level[i], static_cast<TokenIndex>(i), level[i + 1]))
+                                : arena.Make<BinaryOperationNode>(level[i], static_cast<TokenIndex>(i), level[i + 1]);
+            next.push_back(op);
+            nodes.push_back(op);
+        }
+        if (level.size() % 2) next.push_back(level.back());
+        level.swap(next);
     }
-    else throw UnexpectedTokenException(lexer->GetCurrentToken(), GetSourceLine ? GetSourceLine(coords.line) : "");
+
+    // Every node once per run, in allocation order, so only the cost of getting to the right Visit is measured
+    constexpr int runs = 20;
+    VirtualCounter virtualCounter;
+    auto start = std::chrono::steady_clock::now();
+    for (int run = 0; run < runs; ++run) for (ASTNode* n : nodes) n->Accept(virtualCounter);
+    const std::chrono::duration<double, std::nano> virtualTime = std::chrono::steady_clock::now() - start;
+
+    DispatchedCounter dispatchedCounter;
+    start = std::chrono::steady_clock::now();
+    for (int run = 0; run < runs; ++run) for (ASTNode* n : nodes) Dispatch(dispatchedCounter, *n);
+    const std::chrono::duration<double, std::nano> dispatchTime = std::chrono::steady_clock::now() - start;
+
+    const double visits = static_cast<double>(runs) * nodes.size();
+    Logger::Info("Dispatch over {} nodes: Accept and virtual Visit {:.2f} ns per node, Dispatch {:.2f} ns per node ({:.2f}x)\n",
+        nodes.size(), virtualTime.count() / visits, dispatchTime.count() / visits, virtualTime.count() / dispatchTime.count());
+    if (virtualCounter.counter.sum != dispatchedCounter.sum) Logger::Error("Dispatch visited different nodes than Accept!\n");
+}
+
+bool Parser::Expect(const TokenID tokenType)
+{
+    if (lexer->Consume(tokenType)) return true;
+    Unexpected(tokenType);
+    return false;
+}
+
+void Parser::Unexpected(const TokenID expected)
+{
+    // Anything else that does not fit before the parser gets back on track follows from this error
+    if (!panicking) diagnostics.Report(DiagnosticCode::UnexpectedToken, lexer->GetCurrentTokenIndex(), expected);
+    panicking = true;
 }
 
-// TERM := FACTOR ((MUL | DIV) FACTOR)*
-UnqPtr<ASTNode> Parser::ParseTerm()
+void Parser::Synchronize(const TokenIndex statementStart)
 {
-    UnqPtr<ASTNode> node = ParseFactor();
+    if (!panicking) return;
 
-    while (lexer->GetCurrentTokenType() == TokenID::MUL || lexer->GetCurrentTokenType() == TokenID::DIV)
+    // The statement in error may have made it to its semicolon regardless
+    if (lexer->GetCurrentTokenIndex() > statementStart && lexer->GetPreviousTokenType() == TokenID::SEMI)
     {
-        const auto& token = lexer->GetCurrentToken();
-        lexer->Consume(token.type);
-        node = std::make_unique<BinaryOperationNode>(std::move(node), token, ParseFactor());
+        panicking = false;
+        return;
     }
-    return node;
+
+    // Otherwise skip to the end of it, or to the end of the statement list it is in
+    TokenID type = lexer->GetCurrentTokenType();
+    for (; type != TokenID::SEMI && type != TokenID::RCURLY && type != TokenID::ENDF; type = lexer->GetCurrentTokenType()) lexer->Consume(type);
+    if (type == TokenID::SEMI) lexer->Consume(type);
+    // There is nothing to get back on track with at the end of the file, the brackets left open there follow from the
+    // error (which was likely reported at the end of the file already)
+    panicking = type == TokenID::ENDF;
 }
 
-// EXPRESSION := TERM ((PLUS | MINUS) TERM)* <---
-UnqPtr<ASTNode> Parser::ParseExpr()
+// Moves every token a node refers to from `from` on by shift, to where an edit has put it
+struct TokenShifter
 {
-    UnqPtr<ASTNode> node = ParseTerm();
+    TokenIndex from;
+    ptrdiff_t shift;
+
+    void Move(TokenIndex& t) const       { if (t >= from) t = static_cast<TokenIndex>(t + shift); }
+    void Visit(ASTNode& n)               {}
+    void Visit(IdentifierNode& n)        { Move(n.token); }
+    void Visit(UnaryOperationNode& n)    { Move(n.op); }
+    void Visit(BinaryASTNode& n)         { Move(n.op); }
+    void Visit(CompoundStatementNode& n) { Move(n.open); Move(n.close); }
+    void Visit(DeclareStatementNode& n)  { Move(n.type); }
+};
+
+bool Parser::Reparse(const Lexer::TokenEdit& edit, const TokenStream* parsedFrom)
+{
+    // Needs the pointer tree of the very stream that was edited
+    if (flat || !ast.root || !edit.previous || edit.previous != parsedFrom || ast.arena.GetNodeCount() >= 2 * fullParseNodes) return false;
+    if (edit.first == edit.oldEnd && edit.first == edit.newEnd) return true;
+
+    CompoundStatementNode* list = FindEnclosingList(edit.first, edit.oldEnd);
+    if (!list) return false;
 
-    while (lexer->GetCurrentTokenType() == TokenID::ADD || lexer->GetCurrentTokenType() == TokenID::SUB)
+    // The tokens after the edit are the same ones, only at other indices. Done before the list is parsed,
+    // whose new nodes already refer to the new indices
+    const ptrdiff_t shift = static_cast<ptrdiff_t>(edit.newEnd) - static_cast<ptrdiff_t>(edit.oldEnd);
+    if (shift != 0)
     {
-        const auto& token = lexer->GetCurrentToken();
-        lexer->Consume(token.type);
-        node = std::make_unique<BinaryOperationNode>(std::move(node), token, ParseTerm());
+        TokenShifter shifter { edit.oldEnd, shift };
+        for (ASTNode* n : ast.arena.GetNodes()) Dispatch(shifter, *n);
     }
-    return node;
+
+    // The list has to end at the same bracket as before, or the edit changed which brackets pair up
+    const TokenIndex open = list->open;
+    const TokenIndex close = list->close;
+    list->statements.clear();
+    lexer->Seek(open);
+    ParseStatementList(*list);
+    if (!diagnostics.empty() || list->close != close)
+    {
+        Logger::Debug("Edit reaches outside of the statement list at {}, parsing everything again\n", open);
+        diagnostics.Clear();
+        panicking = false;
+        lexer->ResetIndex();
+        return false;
+    }
+
+    ast.changed.push_back(list);
+    Logger::Info("Parsing Successful, re-parsed the statement list of tokens {} to {}\n", open, close);
+    return true;
 }
 
-// BOOL_EXPR := EXPR REL_OP EXPR
-UnqPtr<ASTNode> Parser::ParseBoolExpr()
+CompoundStatementNode* Parser::FindEnclosingList(const TokenIndex first, const TokenIndex oldEnd) const
 {
-    UnqPtr<ASTNode> node = ParseExpr();
-    while (lexer->GetCurrentTokenType() == TokenID::LT  || lexer->GetCurrentTokenType() == TokenID::GT  ||
-           lexer->GetCurrentTokenType() == TokenID::LTE || lexer->GetCurrentTokenType() == TokenID::GTE ||
-           lexer->GetCurrentTokenType() == TokenID::EQ  || lexer->GetCurrentTokenType() == TokenID::NEQ)
+    const auto encloses = [first, oldEnd](ASTNode* n) {
+        return n && (n->kind == NodeKind::CompoundStatement || n->kind == NodeKind::StatementBlock) &&
+            static_cast<CompoundStatementNode*>(n)->open < first && oldEnd <= static_cast<CompoundStatementNode*>(n)->close;
+    };
+    if (!encloses(ast.root)) return nullptr;
+
+    // Lists nest, so at most one of the lists directly under a statement of an enclosing list encloses the edit as well
+    CompoundStatementNode* list = static_cast<CompoundStatementNode*>(ast.root);
+    std::vector<ASTNode*> inner;
+    for (bool deeper = true; deeper;)
     {
-        const auto& token = lexer->GetCurrentToken();
-        lexer->Consume(token.type);
-        node = std::make_unique<ConditionNode>(std::move(node), token, ParseExpr());  // shouldnt be a condition in the long run
+        deeper = false;
+        for (size_t i = 0; i < list->statements.size() && !deeper; ++i)
+        {
+            ASTNode* statement = list->statements[i];
+            inner.clear();
+            switch (statement->kind)
+            {
+            case NodeKind::StatementBlock: inner.push_back(statement); break;
+            case NodeKind::While:
+            case NodeKind::DoWhile:        inner.push_back(static_cast<IterationNode*>(statement)->body); break;
+            case NodeKind::IfStatement:
+                for (IfNode* ifNode : static_cast<IfStatementNode*>(statement)->ifNodes) inner.push_back(ifNode->body);
+                inner.push_back(static_cast<IfStatementNode*>(statement)->elseBody);
+                break;
+            default: break;
+            }
+            for (ASTNode* n : inner) if (encloses(n)) { list = static_cast<CompoundStatementNode*>(n); deeper = true; break; }
+        }
     }
-    return node;
+    return list;
 }
 
-//CONDITION := BOOL_EXPR (LOG_AND|LOG_OR) BOOL_EXPR | 
-            // BOOL_EXPR (LOG_AND|LOG_OR) CONDITION
-UnqPtr<ASTNode> Parser::ParseCond()
+// Binding powers of the infix and postfix operators, indexed by TokenID. An operator takes the expression on its left
+// when its left power is at least what the caller is parsing for, then parses the one on its right with its right power:
+// one above the left for left associative operators, one below for right associative ones, 0 for postfix operators.
+// Tokens that are not operators keep a left power of 0 and end the expression.
+struct BindingPower
 {
-    // Flag for handling parentheses when parsing factors.
-    // If at the process of parsing a condition, parentheses
-    // mean another condition is coming not an arithmetic expression
-    parsingCond = true;
-    UnqPtr<ASTNode> node = ParseBoolExpr();
+    uint8_t left = 0;
+    uint8_t right = 0;
+    bool condition = false;  // Relational and logical operators make ConditionNodes, the rest BinaryOperationNodes
+};
+
+static constexpr std::array<BindingPower, static_cast<size_t>(TokenID::UNKNOWN) + 1> bindingPowers = []() {
+    std::array<BindingPower, static_cast<size_t>(TokenID::UNKNOWN) + 1> table{};
+    const auto set = [&table](const std::initializer_list<TokenID> ops, const BindingPower power) { for (const TokenID op : ops) table[static_cast<size_t>(op)] = power; };
+    set({ TokenID::ASSIGN, TokenID::ADD_ASGN, TokenID::SUB_ASGN, TokenID::MUL_ASGN, TokenID::DIV_ASGN, TokenID::MOD_ASGN,
+          TokenID::XOR_ASGN, TokenID::SHL_ASGN, TokenID::SHR_ASGN, TokenID::B_OR_ASGN, TokenID::B_AND_ASGN }, { Parser::assignmentPower, Parser::assignmentPower - 1 });
+    set({ TokenID::TERNARY },                                                          { 4, 3 });
+    set({ TokenID::OR },                                                               { 5, 6, true });
+    set({ TokenID::AND },                                                              { 7, 8, true });
+    set({ TokenID::BIT_OR },                                                           { 9, 10 });
+    set({ TokenID::BIT_XOR },                                                          { 11, 12 });
+    set({ TokenID::BIT_AND },                                                          { 13, 14 });
+    set({ TokenID::EQ, TokenID::NEQ },                                                 { 15, 16, true });
+    set({ TokenID::LT, TokenID::GT, TokenID::LTE, TokenID::GTE },                      { 17, 18, true });
+    set({ TokenID::SHL, TokenID::SHR },                                                { 19, 20 });
+    set({ TokenID::ADD, TokenID::SUB },                                                { 21, 22 });
+    set({ TokenID::MUL, TokenID::DIV, TokenID::MOD },                                  { 23, 24 });
+    set({ TokenID::INCR, TokenID::DECR },                                              { 27, 0 });
+    return table;
+}();
+
+static const BindingPower& GetBindingPower(const TokenID type) { return bindingPowers[static_cast<size_t>(type)]; }
+
+// PRIMARY := INTEGER | IDENTIFIER, what is left once ParseExpr is done with prefix operators and brackets
+ASTNode* Parser::ParsePrimary()
+{
+    const TokenID tokType = lexer->GetCurrentTokenType();
+    const TokenIndex currentToken = lexer->GetCurrentTokenIndex();
+    switch (tokType)
+    {
+    case TokenID::INT_LITERAL:
+    {
+        const std::string_view spelling = lexer->GetCurrentTokenVal();
+        int value = 0;
+        // Reported rather than let through as some other value, the tree is not handed on
+        if (std::from_chars(spelling.data(), spelling.data() + spelling.size(), value).ec == std::errc::result_out_of_range)
+            diagnostics.Report(DiagnosticCode::LiteralOutOfRange, currentToken);
+        Expect(TokenID::INT_LITERAL);
+        return ast.arena.Make<IntegerNode>(value);
+    }
+    case TokenID::IDENTIFIER:
+        Expect(TokenID::IDENTIFIER);
+        return ast.arena.Make<IdentifierNode>(currentToken);
+    default:
+        // Stands in for the missing expression, the tree is not handed on anyway
+        Unexpected();
+        return ParseEmpty();
+    }
+}
 
-    while (lexer->GetCurrentTokenType() == TokenID::AND || lexer->GetCurrentTokenType() == TokenID::OR)
+// EXPRESSION := OPERAND (INFIX_OP EXPRESSION | POSTFIX_OP)*, with operators taken by binding power
+// OPERAND    := (ADD | SUB | NOT | BIT_NOT | INCR | DECR) EXPRESSION | LPAR EXPRESSION RPAR | PRIMARY
+// Conditions are expressions as well, their operators just bind looser than arithmetic ones. Every operator (and
+// bracket) still waiting on an operand is kept in operators instead of the call stack, however deep the expression goes
+ASTNode* Parser::ParseExpr(const uint8_t minPower)
+{
+    const size_t outer = operators.size();
+    uint8_t power = minPower;
+    for (;;)
     {
-        const auto& token = lexer->GetCurrentToken();
-        lexer->Consume(token.type);
-        node = std::make_unique<ConditionNode>(std::move(node), token, ParseBoolExpr());  // shouldnt be a condition in the long run
+        // A prefix operator is applied to everything that binds tighter than it, a bracket to a whole expression
+        for (TokenID tokType = lexer->GetCurrentTokenType(); ; tokType = lexer->GetCurrentTokenType())
+        {
+            const TokenIndex token = lexer->GetCurrentTokenIndex();
+            if (tokType == TokenID::LPAR)
+            {
+                Expect(TokenID::LPAR);
+                operators.push_back({ PendingOperator::Kind::Bracket, power, token });
+                power = expressionPower;
+            }
+            else if (tokType == TokenID::ADD || tokType == TokenID::SUB || tokType == TokenID::NOT ||
+                     tokType == TokenID::BIT_NOT || tokType == TokenID::INCR || tokType == TokenID::DECR)
+            {
+                lexer->Consume(tokType);
+                operators.push_back({ PendingOperator::Kind::Prefix, power, token });
+                power = prefixPower;
+            }
+            else break;
+        }
+        ASTNode* node = ParsePrimary();
+
+        for (;;)
+        {
+            const TokenID opType = lexer->GetCurrentTokenType();
+            const BindingPower& binding = GetBindingPower(opType);
+            if (binding.left >= power)
+            {
+                // There is no ':' token nor a node for a conditional expression
+                if (opType != TokenID::TERNARY)
+                {
+                    const TokenIndex token = lexer->GetCurrentTokenIndex();
+                    lexer->Consume(opType);
+                    if (binding.right == 0) { node = ast.arena.Make<UnaryOperationNode>(token, node); continue; }
+                    // shouldnt be a condition in the long run
+                    operators.push_back({ binding.condition ? PendingOperator::Kind::Condition : PendingOperator::Kind::Binary, power, token, node });
+                    power = binding.right;
+                    break;
+                }
+                Unexpected();
+            }
+            // Nothing more binds at this power, node is the operand of the innermost pending operator
+            if (operators.size() == outer) return node;
+            const PendingOperator pending = operators.back();
+            operators.pop_back();
+            power = pending.power;
+            switch (pending.kind)
+            {
+            case PendingOperator::Kind::Prefix:    node = ast.arena.Make<UnaryOperationNode>(pending.op, node); break;
+            case PendingOperator::Kind::Bracket:   Expect(TokenID::RPAR); break;
+            case PendingOperator::Kind::Binary:    node = ast.arena.Make<BinaryOperationNode>(pending.left, pending.op, node); break;
+            case PendingOperator::Kind::Condition: node = ast.arena.Make<ConditionNode>(pending.left, pending.op, node); break;
+            }
+        }
     }
-    parsingCond = false;
-    return node;
 }
 
-UnqPtr<ASTNode> Parser::ParseIfCond()
+ASTNode* Parser::ParseIfCond()
 {
-    lexer->Consume(TokenID::IF);
-    lexer->Consume(TokenID::LPAR);
-    UnqPtr<ASTNode> conditionNode = ParseCond();
-    lexer->Consume(TokenID::RPAR);
+    Expect(TokenID::IF);
+    Expect(TokenID::LPAR);
+    ASTNode* conditionNode = ParseExpr();
+    Expect(TokenID::RPAR);
     return conditionNode;
 }
 
 // IF_STATEMENT =: IF_KEY LPAR CONDITION RPAR { COMPOUND_STATEMENT }  [MORE NEEDED HERE]
-UnqPtr<ASTNode> Parser::ParseIfStatement()
+ASTNode* Parser::ParseIfStatement()
 {
-    UnqPtr<IfStatementNode> ifStatement = std::make_unique<IfStatementNode>();
-    ifStatement->AddNode(std::make_unique<IfNode>(ParseCompoundStatement(), ParseIfCond()));
+    IfStatementNode* ifStatement = ast.arena.Make<IfStatementNode>();
+    ifStatement->AddNode(ast.arena.Make<IfNode>(ParseCompoundStatement(), ParseIfCond()));
     while (lexer->GetCurrentTokenType() == TokenID::ELSE)  // Can be 0 or more else if's and 0 or 1 else
     {
         // Is there an else if coming?
-        lexer->Consume(TokenID::ELSE);
+        Expect(TokenID::ELSE);
         if (lexer->GetCurrentTokenType() == TokenID::IF)
-            ifStatement->AddNode(std::make_unique<IfNode>(ParseCompoundStatement(), ParseIfCond()));
+            ifStatement->AddNode(ast.arena.Make<IfNode>(ParseCompoundStatement(), ParseIfCond()));
         else // So it is just an else
         {
             ifStatement->elseBody = ParseCompoundStatement();
@@ -163,38 +474,38 @@ UnqPtr<ASTNode> Parser::ParseIfStatement()
 }
 
 // WHILE_STATEMENT := WHILE LPAR CONDITION RPAR { COMPOUND_STATEMENT }
-UnqPtr<ASTNode> Parser::ParseWhile()
+ASTNode* Parser::ParseWhile()
 {
-    lexer->Consume(TokenID::WHILE);
-    lexer->Consume(TokenID::LPAR);
-    UnqPtr<ASTNode> conditionNode = ParseCond();
-    lexer->Consume(TokenID::RPAR);
+    Expect(TokenID::WHILE);
+    Expect(TokenID::LPAR);
+    ASTNode* conditionNode = ParseExpr();
+    Expect(TokenID::RPAR);
 
     // Body of while statement can be a collection of statements
-    return std::make_unique<WhileNode>(std::move(conditionNode), ParseCompoundStatement());
+    return ast.arena.Make<WhileNode>(conditionNode, ParseCompoundStatement());
 }
 
 // DO_WHILE_STATEMENT := DO { COMPOUND_STATEMENT } WHILE LPAR CONDITION RPAR
-UnqPtr<ASTNode> Parser::ParseDoWhile()
+ASTNode* Parser::ParseDoWhile()
 {
-    lexer->Consume(TokenID::DO);
-    UnqPtr<ASTNode> bodyNode = ParseCompoundStatement();
-    lexer->Consume(TokenID::WHILE);
-    lexer->Consume(TokenID::LPAR);
-    UnqPtr<ASTNode> conditionNode = ParseCond();
-    lexer->Consume(TokenID::RPAR);
+    Expect(TokenID::DO);
+    ASTNode* bodyNode = ParseCompoundStatement();
+    Expect(TokenID::WHILE);
+    Expect(TokenID::LPAR);
+    ASTNode* conditionNode = ParseExpr();
+    Expect(TokenID::RPAR);
 
     // Body of do while statement can be a collection of statements
-    return std::make_unique<DoWhileNode>(std::move(conditionNode), std::move(bodyNode));
+    return ast.arena.Make<DoWhileNode>(conditionNode, bodyNode);
 }
 
 // PROGRAM := int main LPAR RPAR { COMPOUND_STATEMENT }
-UnqPtr<ASTNode> Parser::ParseProgram()                            // hacky way for only main now - ParseTranslationUnit-> ParseFunction or ParseDeclaration
+ASTNode* Parser::ParseProgram()                                   // hacky way for only main now - ParseTranslationUnit-> ParseFunction or ParseDeclaration
 {
-    lexer->Consume(TokenID::INT_TYPE);
-    lexer->Consume(TokenID::MAIN);                                // hack here as well
-    lexer->Consume(TokenID::LPAR); 
-    lexer->Consume(TokenID::RPAR);
+    Expect(TokenID::INT_TYPE);
+    Expect(TokenID::MAIN);                                // hack here as well
+    Expect(TokenID::LPAR); 
+    Expect(TokenID::RPAR);
 
     return ParseCompoundStatement();
 }
@@ -202,43 +513,45 @@ UnqPtr<ASTNode> Parser::ParseProgram()                            // hacky way f
 // BLOCK := { COMPOUND_STATEMENT }
 // Used mainly to take care of scopes not attached to statements. Needs to be
 // a seperate class to be visited by the semantic analyzer.
-UnqPtr<ASTNode> Parser::ParseStatementBlock()
+ASTNode* Parser::ParseStatementBlock()
 {
-    UnqPtr<StatementBlockNode> compound = std::make_unique<StatementBlockNode>();
-    for (auto& statement : ParseStatementList()) compound->Push(std::move(statement));
+    StatementBlockNode* compound = ast.arena.Make<StatementBlockNode>();
+    ParseStatementList(*compound);
 
     return compound;
 }
 
 // COMPOUND_STATEMENT := LCUR STATEMENT_LIST RCUR
-UnqPtr<ASTNode> Parser::ParseCompoundStatement()
+ASTNode* Parser::ParseCompoundStatement()
 {
-    UnqPtr<CompoundStatementNode> compound = std::make_unique<CompoundStatementNode>();
-    for (auto& statement : ParseStatementList()) compound->Push(std::move(statement));
+    CompoundStatementNode* compound = ast.arena.Make<CompoundStatementNode>();
+    ParseStatementList(*compound);
 
     return compound;
 }
 
 // STATEMENT_LIST := STATEMENT | STATEMENT SEMICOLON STATEMENT_LIST 
-std::vector<UnqPtr<ASTNode>> Parser::ParseStatementList()
+void Parser::ParseStatementList(CompoundStatementNode& list)
 {
-    lexer->Consume(TokenID::LCURLY);
-    UnqPtr<ASTNode> node = ParseStatement();
+    list.open = lexer->GetCurrentTokenIndex();
+    Expect(TokenID::LCURLY);
 
-    std::vector<UnqPtr<ASTNode>> nodes;
-    nodes.push_back(std::move(node));
-
-    // Statement list ends at a closing curly bracket
-    while (lexer->GetCurrentTokenType() != TokenID::RCURLY) nodes.push_back(ParseStatement());
-    lexer->Consume(TokenID::RCURLY);
-    return nodes;
+    // Statement list ends at a closing curly bracket (or the end of the file if it was never closed)
+    do
+    {
+        const TokenIndex statementStart = lexer->GetCurrentTokenIndex();
+        list.Push(ParseStatement());
+        Synchronize(statementStart);
+    } while (lexer->GetCurrentTokenType() != TokenID::RCURLY && lexer->GetCurrentTokenType() != TokenID::ENDF);
+    list.close = lexer->GetCurrentTokenIndex();
+    Expect(TokenID::RCURLY);
 }
 
 // STATEMENT : COMPOUND_STATEMENT | ASSIGN_STATEMENT |
 // ITERATION_STATEMENT | DECL | ASSIGN | STATEMENT_BLOCK | EMPTY_STATEMENT
-UnqPtr<ASTNode> Parser::ParseStatement()                                               // FOR/OTHER STAMENTS..etc go here
+ASTNode* Parser::ParseStatement()                                                      // FOR/OTHER STAMENTS..etc go here
 {
-    const auto&[tokenValue, coords, tokenType] = lexer->GetCurrentToken();
+    const TokenID tokenType = lexer->GetCurrentTokenType();
     if         (tokenType == TokenID::IF)         return ParseIfStatement();
     else if    (tokenType == TokenID::WHILE)      return ParseWhile();                  // Merge Loop Statements?
     else if    (tokenType == TokenID::DO)         return ParseDoWhile();
@@ -249,64 +562,68 @@ UnqPtr<ASTNode> Parser::ParseStatement()
     else if    (tokenType == TokenID::RCURLY)     return ParseEmpty();
     else if    (tokenType == TokenID::SEMI)       // Just an empty statement (semicolon on its own)
     { 
-        lexer->Consume(TokenID::SEMI); 
+        Expect(TokenID::SEMI); 
         return ParseEmpty();
     }
-                                                
-    throw UnexpectedTokenException(lexer->GetCurrentToken(), GetSourceLine ? GetSourceLine(coords.line) : "");
+
+    Unexpected();
+    return ParseEmpty();
 }
 
 // DECLARATION_STATEMENT := TYPE_SPECIFIER IDENTIFIER SEMI |
                           //TYPE_SPECIFIER ASSIGN_STATEMENT
-UnqPtr<ASTNode> Parser::ParseDeclarationStatement() // in the future it should accommodate function declarations also
+ASTNode* Parser::ParseDeclarationStatement()        // in the future it should accommodate function declarations also
 {
     // Get the type specifier (int, float, char etc..) and consume it
-    const auto& [tokenValue, coords, tokenType] = lexer->GetCurrentToken();
-    const auto& currentTokenInfo = lexer->GetCurrentToken();
+    const TokenID tokenType = lexer->GetCurrentTokenType();
+    const TokenIndex typeToken = lexer->GetCurrentTokenIndex();
     lexer->Consume(tokenType);
 
     // Next is identifier so process it
-    UnqPtr<IdentifierNode> ident = std::make_unique<IdentifierNode>(lexer->GetCurrentToken());
-    lexer->Consume(TokenID::IDENTIFIER);
+    IdentifierNode* ident = ast.arena.Make<IdentifierNode>(lexer->GetCurrentTokenIndex());
+    Expect(TokenID::IDENTIFIER);
     // If there is an assignment following this is a declaration and assignment statement in one
     if (lexer->GetCurrentTokenType() == TokenID::ASSIGN)
     {
-        const auto& assignTok = lexer->GetCurrentToken();
+        const TokenIndex assignTok = lexer->GetCurrentTokenIndex();
         // Process the rest as a declare and assign statement
-        lexer->Consume(TokenID::ASSIGN);
-        UnqPtr<DeclareAssignNode> node = 
-            std::make_unique<DeclareAssignNode>(
-                std::make_unique<DeclareStatementNode>(std::move(ident), currentTokenInfo),
+        Expect(TokenID::ASSIGN);
+        DeclareAssignNode* node = 
+            ast.arena.Make<DeclareAssignNode>(
+                ast.arena.Make<DeclareStatementNode>(ident, typeToken),
                 assignTok,
                 ParseExpr());
-        lexer->Consume(TokenID::SEMI);
+        Expect(TokenID::SEMI);
         return node;
     }
     // Or is was just a declaration statement
-    lexer->Consume(TokenID::SEMI);
-    return std::make_unique<DeclareStatementNode>(std::move(ident), currentTokenInfo);
+    Expect(TokenID::SEMI);
+    return ast.arena.Make<DeclareStatementNode>(ident, typeToken);
 }
 
-// ASSIGN_STATEMENT := IDENTIFIER ASSIGN EXPRESSION
-UnqPtr<ASTNode> Parser::ParseAssignStatement()
+// ASSIGN_STATEMENT := IDENTIFIER (ASSIGN | ADD_ASGN | SUB_ASGN | ...) EXPRESSION
+ASTNode* Parser::ParseAssignStatement()
 {
-    UnqPtr<IdentifierNode> ident = std::make_unique<IdentifierNode>(lexer->GetCurrentToken());
-    lexer->Consume(TokenID::IDENTIFIER);
-    const auto& assignTok = lexer->GetCurrentToken();
-    lexer->Consume(TokenID::ASSIGN);
-    UnqPtr<ASTNode> node = std::make_unique<AssignStatementNode>(std::move(ident), assignTok, ParseExpr());
-    lexer->Consume(TokenID::SEMI);
+    IdentifierNode* ident = ast.arena.Make<IdentifierNode>(lexer->GetCurrentTokenIndex());
+    Expect(TokenID::IDENTIFIER);
+    // Plain or compound assignment
+    const TokenIndex assignTok = lexer->GetCurrentTokenIndex();
+    const TokenID assignType = lexer->GetCurrentTokenType();
+    if (GetBindingPower(assignType).left != assignmentPower) { Unexpected(); return ident; }
+    lexer->Consume(assignType);
+    ASTNode* node = ast.arena.Make<AssignStatementNode>(ident, assignTok, ParseExpr());
+    Expect(TokenID::SEMI);
     return node;
 }
 
 // RETURN_STATEMENT := RETURN EXPRESSION
-UnqPtr<ASTNode> Parser::ParseReturn()
+ASTNode* Parser::ParseReturn()
 {
-    lexer->Consume(TokenID::RET);
+    Expect(TokenID::RET);
 
-    UnqPtr<ASTNode> node = std::make_unique<ReturnStatementNode>(ParseExpr());
-    lexer->Consume(TokenID::SEMI);
+    ASTNode* node = ast.arena.Make<ReturnStatementNode>(ParseExpr());
+    Expect(TokenID::SEMI);
     return node;
 }
 
-UnqPtr<ASTNode> Parser::ParseEmpty() { return std::make_unique<EmptyStatementNode>(); }
\ No newline at end of file
+ASTNode* Parser::ParseEmpty() { return ast.arena.Make<EmptyStatementNode>(); }
\ No newline at end of file
@@ -1,40 +1,82 @@
 #pragma once
 #include "../Lexer/Lexer.h"
 #include "../AST/AbstractSyntaxTree.h"
+#include "../Util/Error.h"
 
-class Parser : public IObserver<>, public Subject<ASTNode>
+class Parser : public IObserver<>, public Subject<SyntaxTree>
 {
+public:
+    // Binding powers that are not an operator's own, see bindingPowers
+    static constexpr uint8_t assignmentPower = 2;  // Assignments only appear as statements, expressions are parsed above them
+    static constexpr uint8_t expressionPower = 3;
+    static constexpr uint8_t prefixPower     = 25; // Binds tighter than any infix operator
 private:
     Lexer* lexer;
-    UnqPtr<ASTNode> root;
+    SyntaxTree ast;
 
+    Diagnostics diagnostics;
+    // Arena nodes after the last full parse. Statements replaced by a reparse stay in the arena until the next
+    // full parse, which is not put off any longer once they could make up half of it
+    size_t fullParseNodes = 0;
+    bool panicking = false;  // Recovering from an error, until the end of the statement it was found in
     bool failState = false;
-    bool parsingCond = false;
     bool shouldRun = false;
+    bool flat = false;
+
+    // An operator (or bracket) whose operand is being parsed, and the binding power of the expression it is in
+    struct PendingOperator
+    {
+        enum class Kind : uint8_t { Prefix, Bracket, Binary, Condition } kind;
+        uint8_t power;
+        TokenIndex op;
+        ASTNode* left = nullptr;  // Of a binary operator
+    };
+    std::vector<PendingOperator> operators;
+
+    // Consumes a token of tokenType, or reports the current one in its place
+    bool Expect(const TokenID tokenType);
+    // Reports the current token, unless an error was already reported for the statement being parsed
+    void Unexpected(const TokenID expected = TokenID::UNKNOWN);
+    // After a statement that started at statementStart, skips whatever is left of it if it had an error
+    void Synchronize(const TokenIndex statementStart);
 
-    UnqPtr<ASTNode> ParseFactor();
-    UnqPtr<ASTNode> ParseTerm();
-    UnqPtr<ASTNode> ParseExpr();
-    UnqPtr<ASTNode> ParseBoolExpr();
-    UnqPtr<ASTNode> ParseCond();
-    UnqPtr<ASTNode> ParseIfCond();
-    UnqPtr<ASTNode> ParseIfStatement();
-    UnqPtr<ASTNode> ParseWhile();
-    UnqPtr<ASTNode> ParseDoWhile();
-    UnqPtr<ASTNode> ParseProgram();
-    UnqPtr<ASTNode> ParseStatementBlock();
-    UnqPtr<ASTNode> ParseCompoundStatement();
-    std::vector<UnqPtr<ASTNode>> ParseStatementList();
-    UnqPtr<ASTNode> ParseDeclarationStatement();
-    UnqPtr<ASTNode> ParseStatement();
-    UnqPtr<ASTNode> ParseAssignStatement();
-    UnqPtr<ASTNode> ParseReturn();
-    UnqPtr<ASTNode> ParseEmpty();
+    // Parses again only the innermost statement list the lexer's last edit is in, keeping the rest of the tree.
+    // False if the tree has to be parsed from scratch instead (the edit reached outside of the list)
+    bool Reparse(const Lexer::TokenEdit& edit, const TokenStream* parsedFrom);
+    // The innermost statement list with both its brackets outside of previous tokens [first, oldEnd)
+    CompoundStatementNode* FindEnclosingList(const TokenIndex first, const TokenIndex oldEnd) const;
+
+    ASTNode* ParsePrimary();
+    // Parses an expression made of operators that bind at least as tight as minPower
+    ASTNode* ParseExpr(const uint8_t minPower = expressionPower);
+    ASTNode* ParseIfCond();
+    ASTNode* ParseIfStatement();
+    ASTNode* ParseWhile();
+    ASTNode* ParseDoWhile();
+    ASTNode* ParseProgram();
+    ASTNode* ParseStatementBlock();
+    ASTNode* ParseCompoundStatement();
+    void ParseStatementList(CompoundStatementNode& list);
+    ASTNode* ParseDeclarationStatement();
+    ASTNode* ParseStatement();
+    ASTNode* ParseAssignStatement();
+    ASTNode* ParseReturn();
+    ASTNode* ParseEmpty();
 public:
     Parser(Lexer* lex) : lexer(lex) {}
 
+    // Hand observers a FlatAST instead of the pointer tree, which is then released right after parsing
+    void SetFlat(const bool f) { flat = f; }
+    bool IsFlat() const        { return flat; }
+    const Diagnostics& GetDiagnostics() const { return diagnostics; }
+    // Logs the size of every kind of node and what the current AST costs per node, as a tree and as a FlatAST
+    void BenchmarkMemory() const;
+    // Visits every node of a synthetic tree of at least nodeCount expression nodes through Accept and a virtual Visit,
+    // then through Dispatch, and logs the cost of each per node
+    void BenchmarkDispatch(const size_t nodeCount = 1 << 20) const;
+
     // Inherited via the Subject Interface
-    virtual void NotifyObservers(const Notify what) override { for (auto& obs : observers) obs->Update(root.get()); }
+    virtual void NotifyObservers(const Notify what) override { for (auto& obs : observers) obs->Update(&ast); }
 
     // Inherited via IObserver Interface
     virtual bool ShouldRun() const override { return shouldRun; }
@@ -0,0 +1,132 @@
+#include <cmath>
+
+#include "Expression.h"
+
+// Operators C only defines on integers
+static bool IsIntegral(const TokenID op)
+{
+    return op == TokenID::MOD || op == TokenID::SHL || op == TokenID::SHR || op == TokenID::BIT_AND || op == TokenID::BIT_OR || op == TokenID::BIT_XOR;
+}
+
+// Relational, equality and logical operators, which give an int (0 or 1) whatever they compare
+static bool IsBoolean(const TokenID op)
+{
+    return (op >= TokenID::GT && op <= TokenID::NEQ) || op == TokenID::AND || op == TokenID::OR;
+}
+
+static float AsFloat(const ExpressionInfo& e) { return e.type == ValueType::FLOAT ? e.value.f : static_cast<float>(e.value.i); }
+
+// Done in 64 bits, where no operation on two int32s can overflow, and checked to fit back in 32
+static ExpressionInfo FoldInt(const TokenID op, const int64_t a, const int64_t b, const TokenIndex at, Diagnostics& diagnostics)
+{
+    int64_t result = 0;
+    switch (op)
+    {
+    case TokenID::ADD:     result = a + b; break;
+    case TokenID::SUB:     result = a - b; break;
+    case TokenID::MUL:     result = a * b; break;
+    case TokenID::DIV:
+    case TokenID::MOD:
+        // INT_MIN / -1 does not fit, and C leaves INT_MIN % -1 undefined along with it. Both round towards zero otherwise
+        if (a == INT32_MIN && b == -1) { diagnostics.Report(DiagnosticCode::Overflow, at); return { ValueType::INT }; }
+        result = op == TokenID::DIV ? a / b : a % b;
+        break;
+    case TokenID::SHL:
+    case TokenID::SHR:
+        // Shifting a negative value right is implementation defined, it is arithmetic like the target's sar.
+        // Shifting one left is undefined
+        if (op == TokenID::SHR) { result = a >> b; break; }
+        if (a < 0) { diagnostics.Report(DiagnosticCode::Overflow, at); return { ValueType::INT }; }
+        result = a << b;
+        break;
+    case TokenID::BIT_AND: result = a & b;  break;
+    case TokenID::BIT_OR:  result = a | b;  break;
+    case TokenID::BIT_XOR: result = a ^ b;  break;
+    case TokenID::GT:      result = a > b;  break;
+    case TokenID::LT:      result = a < b;  break;
+    case TokenID::GTE:     result = a >= b; break;
+    case TokenID::LTE:     result = a <= b; break;
+    case TokenID::EQ:      result = a == b; break;
+    case TokenID::NEQ:     result = a != b; break;
+    case TokenID::AND:     result = a && b; break;
+    case TokenID::OR:      result = a || b; break;
+    default:               return { ValueType::INT };
+    }
+    if (result < INT32_MIN || result > INT32_MAX) { diagnostics.Report(DiagnosticCode::Overflow, at); return { ValueType::INT }; }
+    return ExpressionInfo::Int(static_cast<int32_t>(result));
+}
+
+static ExpressionInfo FoldFloat(const TokenID op, const float a, const float b, const TokenIndex at, Diagnostics& diagnostics)
+{
+    float result = 0.0f;
+    switch (op)
+    {
+    case TokenID::ADD: result = a + b; break;
+    case TokenID::SUB: result = a - b; break;
+    case TokenID::MUL: result = a * b; break;
+    case TokenID::DIV: result = a / b; break;
+    case TokenID::GT:  return ExpressionInfo::Int(a > b);
+    case TokenID::LT:  return ExpressionInfo::Int(a < b);
+    case TokenID::GTE: return ExpressionInfo::Int(a >= b);
+    case TokenID::LTE: return ExpressionInfo::Int(a <= b);
+    case TokenID::EQ:  return ExpressionInfo::Int(a == b);
+    case TokenID::NEQ: return ExpressionInfo::Int(a != b);
+    case TokenID::AND: return ExpressionInfo::Int(a != 0.0f && b != 0.0f);
+    case TokenID::OR:  return ExpressionInfo::Int(a != 0.0f || b != 0.0f);
+    default:           return { ValueType::FLOAT };
+    }
+    if (!std::isfinite(result)) { diagnostics.Report(DiagnosticCode::Overflow, at); return { ValueType::FLOAT }; }
+    return ExpressionInfo::Float(result);
+}
+
+ExpressionInfo CheckUnary(const TokenID op, const ExpressionInfo& operand, const TokenIndex at, Diagnostics& diagnostics)
+{
+    if (operand.type == ValueType::NONE) return {};
+    switch (op)
+    {
+    case TokenID::INCR:
+    case TokenID::DECR:
+        // A constant is no variable to change
+        if (operand.constant) { diagnostics.Report(DiagnosticCode::InvalidOperands, at); return {}; }
+        return { operand.type };
+    case TokenID::BIT_NOT:
+        if (operand.type != ValueType::INT) { diagnostics.Report(DiagnosticCode::InvalidOperands, at); return {}; }
+        return operand.constant ? ExpressionInfo::Int(~operand.value.i) : ExpressionInfo{ ValueType::INT };
+    case TokenID::NOT:
+        return operand.constant ? ExpressionInfo::Int(AsFloat(operand) == 0.0f) : ExpressionInfo{ ValueType::INT };
+    case TokenID::SUB:
+        if (!operand.constant) return { operand.type };
+        if (operand.type == ValueType::FLOAT) return ExpressionInfo::Float(-operand.value.f);
+        if (operand.value.i == INT32_MIN) { diagnostics.Report(DiagnosticCode::Overflow, at); return { ValueType::INT }; }
+        return ExpressionInfo::Int(-operand.value.i);
+    default:  // Unary plus
+        return operand;
+    }
+}
+
+ExpressionInfo CheckBinary(const TokenID op, const ExpressionInfo& left, const ExpressionInfo& right, const TokenIndex at, Diagnostics& diagnostics)
+{
+    if (left.type == ValueType::NONE || right.type == ValueType::NONE) return {};
+    if (IsIntegral(op) && (left.type != ValueType::INT || right.type != ValueType::INT))
+    {
+        diagnostics.Report(DiagnosticCode::InvalidOperands, at);
+        return {};
+    }
+
+    // Usual arithmetic conversions: an int operand is converted to float if the other one is a float
+    const ValueType type = IsBoolean(op) ? ValueType::INT : left.type == ValueType::FLOAT || right.type == ValueType::FLOAT ? ValueType::FLOAT : ValueType::INT;
+    // Undefined as soon as the right operand is known, whatever the left one is
+    if (right.constant && (op == TokenID::DIV || op == TokenID::MOD) && AsFloat(right) == 0.0f)
+    {
+        diagnostics.Report(DiagnosticCode::DivisionByZero, at);
+        return { type };
+    }
+    if (right.constant && (op == TokenID::SHL || op == TokenID::SHR) && (right.value.i < 0 || right.value.i >= 32))
+    {
+        diagnostics.Report(DiagnosticCode::InvalidShift, at);
+        return { type };
+    }
+    if (!left.constant || !right.constant) return { type };
+    if (left.type == ValueType::INT && right.type == ValueType::INT) return FoldInt(op, left.value.i, right.value.i, at, diagnostics);
+    return FoldFloat(op, AsFloat(left), AsFloat(right), at, diagnostics);
+}
\ No newline at end of file
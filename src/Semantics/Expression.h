@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+
+#include "../Lexer/Token.h"
+#include "../Util/Error.h"
+
+// Type of an expression. NONE for nodes that are not expressions, and for ones whose type could not be worked out
+// (an undeclared identifier, invalid operands), which have been reported already
+enum class ValueType : uint8_t { NONE, INT, FLOAT };
+
+// Type a declaration's type specifier (or a literal) gives
+constexpr ValueType GetValueType(const TokenID type)
+{
+    switch (type)
+    {
+    case TokenID::INT_TYPE:
+    case TokenID::INT_LITERAL:   return ValueType::INT;
+    case TokenID::FLOAT_TYPE:
+    case TokenID::FLOAT_LITERAL: return ValueType::FLOAT;
+    default:                     return ValueType::NONE;
+    }
+}
+
+// What the semantic pass knows of an expression: its type and, when it is a compile time constant, its value
+struct ExpressionInfo
+{
+    ValueType type = ValueType::NONE;
+    bool constant = false;
+    union { int32_t i; float f; } value{ 0 };
+
+    static ExpressionInfo Int(const int32_t v)  { ExpressionInfo e{ ValueType::INT, true };   e.value.i = v; return e; }
+    static ExpressionInfo Float(const float v)  { ExpressionInfo e{ ValueType::FLOAT, true }; e.value.f = v; return e; }
+};
+
+// Type of the operator at token op applied to its operand(s), folded into a constant when they all are.
+// What C leaves undefined (overflow, division by zero, shifts out of range) is reported at op and left unfolded
+ExpressionInfo CheckUnary(const TokenID op, const ExpressionInfo& operand, const TokenIndex at, Diagnostics& diagnostics);
+ExpressionInfo CheckBinary(const TokenID op, const ExpressionInfo& left, const ExpressionInfo& right, const TokenIndex at, Diagnostics& diagnostics);
+
+// The operator a compound assignment (x op= y) applies, UNKNOWN for a plain one
+constexpr TokenID GetCompoundOperator(const TokenID assignment)
+{
+    switch (assignment)
+    {
+    case TokenID::ADD_ASGN:   return TokenID::ADD;
+    case TokenID::SUB_ASGN:   return TokenID::SUB;
+    case TokenID::MUL_ASGN:   return TokenID::MUL;
+    case TokenID::DIV_ASGN:   return TokenID::DIV;
+    case TokenID::MOD_ASGN:   return TokenID::MOD;
+    case TokenID::XOR_ASGN:   return TokenID::BIT_XOR;
+    case TokenID::SHL_ASGN:   return TokenID::SHL;
+    case TokenID::SHR_ASGN:   return TokenID::SHR;
+    case TokenID::B_OR_ASGN:  return TokenID::BIT_OR;
+    case TokenID::B_AND_ASGN: return TokenID::BIT_AND;
+    default:                  return TokenID::UNKNOWN;
+    }
+}
\ No newline at end of file
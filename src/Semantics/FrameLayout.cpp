@@ -0,0 +1,53 @@
+#include <algorithm>
+
+#include "FrameLayout.h"
+
+void FrameLayout::Clear()
+{
+    scopes.clear();
+    used = 0;
+    deepest = 0;
+    maxAlign = 1;
+    allocated = 0;
+}
+
+int32_t FrameLayout::Allocate(const SlotType type)
+{
+    // The slot spans [ebp - used, ebp - used + size), so it is the end of it that gets aligned
+    used = (used + type.size + type.align - 1) & ~(type.align - 1);
+    deepest = std::max(deepest, used);
+    maxAlign = std::max(maxAlign, type.align);
+    allocated += type.size;
+
+    FrameExtent& scope = scopes.back().extent;
+    scope.depth = std::max(scope.depth, used - scopes.back().start);
+    scope.allocated += type.size;
+    scope.maxAlign = std::max(scope.maxAlign, type.align);
+    return -static_cast<int32_t>(used);
+}
+
+FrameExtent FrameLayout::CloseScope()
+{
+    const Scope closed = scopes.back();
+    scopes.pop_back();
+    used = closed.start;
+    // Whatever it took counts towards the scope it was nested in
+    if (!scopes.empty())
+    {
+        FrameExtent& parent = scopes.back().extent;
+        parent.depth = std::max(parent.depth, closed.start + closed.extent.depth - scopes.back().start);
+        parent.allocated += closed.extent.allocated;
+        parent.maxAlign = std::max(parent.maxAlign, closed.extent.maxAlign);
+    }
+    return closed.extent;
+}
+
+void FrameLayout::Replay(const FrameExtent& extent)
+{
+    OpenScope();
+    scopes.back().extent = extent;
+    deepest = std::max(deepest, used + extent.depth);
+    maxAlign = std::max(maxAlign, extent.maxAlign);
+    allocated += extent.allocated;
+    CloseScope();
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "../Lexer/Token.h"
+
+// Stack space a variable of a type takes
+struct SlotType
+{
+    uint32_t size;
+    uint32_t align;  // A power of two
+};
+
+constexpr SlotType GetSlotType(const TokenID type)
+{
+    switch (type)
+    {
+    case TokenID::INT_TYPE:   return { 4, 4 };
+    case TokenID::FLOAT_TYPE: return { 4, 4 };
+    default:                  return { 4, 4 };  // Nothing else can be declared yet
+    }
+}
+
+// How far a closed scope, with everything nested in it, took the frame. Enough to lay it out again without its variables
+struct FrameExtent
+{
+    uint32_t depth;      // Below the bytes in use when it opened
+    uint32_t allocated;
+    uint32_t maxAlign;
+};
+
+// Lays out a frame's variables below ebp while scopes open and close. A variable takes the next free slot of its
+// size and alignment, and a scope's slots are free again once it closes: scopes that are never open at the same time
+// (an if's and its else's bodies, consecutive blocks) share their stack space. The frame is as deep as the slots got
+class FrameLayout
+{
+private:
+    struct Scope
+    {
+        uint32_t start;  // Bytes in use when it opened
+        FrameExtent extent;
+    };
+    std::vector<Scope> scopes;  // The open ones
+    uint32_t used = 0;
+    uint32_t deepest = 0;
+    uint32_t maxAlign = 1;
+    uint32_t allocated = 0;
+public:
+    void Clear();
+    void OpenScope() { scopes.push_back({ used, { 0, 0, 1 } }); }
+    FrameExtent CloseScope();
+    // Takes up the room of a scope laid out in an earlier run, which is not walked again, as if it opened and closed here
+    void Replay(const FrameExtent& extent);
+
+    // Offset from ebp of a new slot for a variable of type
+    int32_t Allocate(const SlotType type);
+
+    uint32_t GetBytesInUse() const { return used; }
+    // Bytes to reserve below ebp, a multiple of the largest alignment of any slot
+    uint32_t GetFrameSize()      const { return (deepest + maxAlign - 1) & ~(maxAlign - 1); }
+    // What the frame would take if no slot was ever reused
+    uint32_t GetBytesAllocated() const { return allocated; }
+};
\ No newline at end of file
@@ -1,208 +1,577 @@
+#include <algorithm>
+#include <chrono>
+
+#include <TextEditor.h>
 #include "SemanticAnalyzer.h"
-#include "../Util/Error.h"
+#include "../Parser/Parser.h"
 #include "../Util/Logger.h"
 #include "../Util/Utility.h"
 
-void SemanticAnalyzer::Visit(ASTNode& n)       { assert(("Semantic Analyzer visited base ASTNode class?!"      , false)); }
-void SemanticAnalyzer::Visit(UnaryASTNode& n)  { assert(("Semantic Analyzer visited base UnaryASTNode class?!" , false)); }
-void SemanticAnalyzer::Visit(BinaryASTNode& n) { assert(("Semantic Analyzer visited base BinaryASTNode class?!", false)); }
-void SemanticAnalyzer::Visit(IntegerNode& n)   {}
+void SemanticAnalyzer::Visit(IntegerNode& n)   { expressions[n.index] = ExpressionInfo::Int(n.value); }
 
 void SemanticAnalyzer::Visit(IdentifierNode& n)
 {
     // Every identifier will be hit here, so the address must be set here to the one in the symbol table - FIXME: REFACTOR ADDRESSES
-    if (const auto sym = currentScope->LookUpSymbol(n.token.str); !sym)
-    {
-        failState = true;
-        const auto& [variableName, coords, variableType] = n.token;
-        throw SymbolNotFoundException(n.token, GetSourceLine ? GetSourceLine(coords.line) : "");
-    }
-    else n.offset = sym->offset;
+    // Set either way, the tables keep what the last run left in them when there is a cache
+    const Binding* binding = LookUpIdentifier(n.token);
+    frameSlots[n.index] = binding ? binding->offset : 0;
+    expressions[n.index] = binding ? ExpressionInfo{ binding->type } : ExpressionInfo{};
 }
 
-void SemanticAnalyzer::Visit(UnaryOperationNode& n) { n.expr->Accept(*this); }
-
-void SemanticAnalyzer::Visit(BinaryOperationNode& n)
+const SemanticAnalyzer::Binding* SemanticAnalyzer::LookUpIdentifier(const TokenIndex token)
 {
-    n.left->Accept(*this);
-    n.right->Accept(*this);
+    const Atom atom = tokens->GetAtom(token);
+    const uint32_t binding = innermost[atom];
+    references.push_back({ atom, binding });
+    if (binding != none) return &bindings[binding];
+    diagnostics.Report(DiagnosticCode::UndeclaredIdentifier, token);
+    return nullptr;
 }
 
-void SemanticAnalyzer::Visit(ConditionNode& n)
+// Operators' operands are walked into, and the operators checked on the way out
+void SemanticAnalyzer::Visit(UnaryOperationNode& n)  {}
+void SemanticAnalyzer::Visit(BinaryOperationNode& n) {}
+void SemanticAnalyzer::Visit(ConditionNode& n)       {}
+
+void SemanticAnalyzer::OpenNewScope(const ScopeName& name, const ASTNode* body)
 {
-    n.left->Accept(*this);
-    n.right->Accept(*this);
+    // Nested in the current scope, one level deeper. Global is level 1
+    scopes.push_back({ name, scopeStack.empty() ? none : scopeStack.back().record, static_cast<int>(scopeStack.size()) + 1 });
+    const bool cached = body && (body->kind == NodeKind::CompoundStatement || body->kind == NodeKind::StatementBlock);
+    scopeStack.push_back({ static_cast<uint32_t>(scopes.size() - 1), static_cast<uint32_t>(bindings.size()),
+        cached ? static_cast<const CompoundStatementNode*>(body) : nullptr, static_cast<uint32_t>(variables.size()),
+        static_cast<uint32_t>(diagnostics.size()), static_cast<uint32_t>(references.size()), static_cast<uint32_t>(closed.size()), frame.GetBytesInUse() });
+    frame.OpenScope();
+    ++scopesAnalysed;
 }
 
-SymbolTable* SemanticAnalyzer::CreateNewScope(const ASTNode* n, const char* tag)
+void SemanticAnalyzer::CloseScope()
 {
-    // Generate a name for the new nested scope and add it as a symbol into the parent scope (current)
-    const std::string nestedScopeName = Util::GenerateID(n, tag);
-    currentScope->DefineSymbol(std::make_unique<NestedScope>(nestedScopeName));
-    
-    // New nested scope with the nested scope name, at a greater depth than the current with the current scope as its parent
-    std::unique_ptr<SymbolTable> nestedScope = std::make_unique<SymbolTable>(nestedScopeName, currentScope->scopeLevel + 1, currentScope);
-    
-    // Current scope becomes this new scope
-    currentScope = nestedScope.get();
-    symbolTable.push_back(std::move(nestedScope));
-    
-    return currentScope;
+    // Whatever the scope's definitions hid is visible again
+    const OpenScope scope = scopeStack.back();
+    for (uint32_t i = static_cast<uint32_t>(bindings.size()); i-- > scope.firstBinding;) innermost[bindings[i].atom] = bindings[i].shadowed;
+    bindings.resize(scope.firstBinding);
+    scopeStack.pop_back();
+    // Its variables are out of reach from here on, later ones can have their slots
+    const FrameExtent extent = frame.CloseScope();
+    if (!scope.body) return;
+    StoreScope(scope, extent);
+    if (scopeStack.back().body)
+        closed.push_back({ scope.body->index, scope.body->open, scope.record, static_cast<uint32_t>(scopes.size()), scope.firstVariable,
+            static_cast<uint32_t>(variables.size()), scope.firstDiagnostic, static_cast<uint32_t>(diagnostics.size()) });
 }
 
-void SemanticAnalyzer::Visit(IfNode& n)
+void SemanticAnalyzer::StoreScope(const OpenScope& scope, const FrameExtent& extent)
 {
-    // Visit Condition, Identifiers in the condition belong to the current scope
-    n.condition->Accept(*this);
+    // Lookups of what the scope defined itself only depend on the scope. The rest, one per identifier, is what it
+    // depends on from outside, and stays on the stack as what the scopes it is nested in depend on
+    const auto first = references.begin() + scope.firstReference;
+    auto last = std::remove_if(first, references.end(), [&scope](const Reference& r) { return r.binding != none && r.binding >= scope.firstBinding; });
+    std::sort(first, last, [](const Reference& a, const Reference& b) { return a.atom < b.atom; });
+    last = std::unique(first, last, [](const Reference& a, const Reference& b) { return a.atom == b.atom; });
+    references.erase(last, references.end());
+
+    ScopeCache& entry = cache[scope.body->index];
+    entry.parent = FlatAST::none;
+    for (auto open = scopeStack.rbegin(); open != scopeStack.rend(); ++open)
+        if (open->body) { entry.parent = open->body->index; break; }
+    entry.frameUsed = scope.frameUsed;
+    entry.extent = extent;
+
+    entry.free.clear();
+    for (auto r = first; r != references.end(); ++r)
+        entry.free.push_back(r->binding == none ? FreeVariable{ r->atom, 0, ValueType::NONE } : FreeVariable{ r->atom, bindings[r->binding].offset, bindings[r->binding].type });
+
+    // The records of the run from where the scope opened are its own, but for the runs of the cached scopes that closed in it
+    const TokenIndex open = scope.body->open;
+    const auto& records = diagnostics.GetRecords();
+    uint32_t r = scope.record, v = scope.firstVariable, d = scope.firstDiagnostic;
+    const auto own = [&](const uint32_t recordEnd, const uint32_t variableEnd, const uint32_t diagnosticEnd) {
+        for (; r < recordEnd; ++r)     entry.scopes.push_back(scopes[r].name);
+        for (; v < variableEnd; ++v)   entry.variables.push_back({ variables[v].name - open, variables[v].type - open, variables[v].offset, 0 });
+        for (; d < diagnosticEnd; ++d) entry.diagnostics.push_back({ records[d].code, records[d].expected, records[d].token - open });
+    };
+    entry.scopes.clear();
+    entry.variables.clear();
+    entry.diagnostics.clear();
+    entry.inner.clear();
+    for (auto c = closed.begin() + scope.firstClosed; c != closed.end(); ++c)
+    {
+        own(c->record, c->variable, c->diagnostic);
+        entry.inner.push_back({ c->body, c->open - open, static_cast<uint32_t>(entry.scopes.size()),
+            static_cast<uint32_t>(entry.variables.size()), static_cast<uint32_t>(entry.diagnostics.size()) });
+        r = c->recordEnd;
+        v = c->variableEnd;
+        d = c->diagnosticEnd;
+    }
+    own(static_cast<uint32_t>(scopes.size()), static_cast<uint32_t>(variables.size()), static_cast<uint32_t>(records.size()));
+    closed.resize(scope.firstClosed);
+}
 
-    // Make a new nested scope for the body of this if (or else_if)
-    SymbolTable* nestedScope = CreateNewScope(&n, (n.type + "_").c_str());
+bool SemanticAnalyzer::ReuseScope(const ASTNode& body)
+{
+    // Its nodes are the same as when it was cached, or it would not be. What they come to only depends on
+    // where the frame stood and on what the identifiers it does not define resolve to
+    const auto it = cache.find(body.index);
+    if (it == cache.end()) return false;
+    const ScopeCache& entry = it->second;
+    if (entry.frameUsed != frame.GetBytesInUse()) return false;
+    for (const FreeVariable& f : entry.free)
+    {
+        const uint32_t b = innermost[f.atom];
+        const bool same = b == none ? f.offset == 0 && f.type == ValueType::NONE : bindings[b].offset == f.offset && bindings[b].type == f.type;
+        if (!same) return false;
+    }
 
-    // Perform Semantic Analysis to the "contents" of this new scope
-    n.body->Accept(*this);
+    // Its identifiers keep their frame slots and types from the run that cached it, the rest of it is added to this one.
+    // The scopes nested in it, with entries of their own (which hold as long as its does), are replayed where they came
+    const TokenIndex open = static_cast<const CompoundStatementNode&>(body).open;
+    const ClosedScope replayed{ body.index, open, static_cast<uint32_t>(scopes.size()), 0, static_cast<uint32_t>(variables.size()), 0,
+        static_cast<uint32_t>(diagnostics.size()), 0 };
+    replaying.push_back({ &entry, open, none, scopeStack.back().record, static_cast<int>(scopeStack.size()) + 1, 0, 0, 0, 0 });
+    while (!replaying.empty())
+    {
+        Replay& top = replaying.back();
+        const ScopeCache& e = *top.entry;
+        const InnerScope* next = top.inner < e.inner.size() ? &e.inner[top.inner] : nullptr;
+        for (; top.scope < (next ? next->scopes : e.scopes.size()); ++top.scope)
+        {
+            // Its own first, the ones it holds that are not cached are nested in it
+            if (top.scope == 0) top.record = static_cast<uint32_t>(scopes.size());
+            scopes.push_back({ e.scopes[top.scope], top.scope == 0 ? top.parent : top.record, top.level + (top.scope != 0) });
+            ++scopesReused;
+        }
+        for (; top.variable < (next ? next->variables : e.variables.size()); ++top.variable)
+        {
+            const VariableRecord& v = e.variables[top.variable];
+            variables.push_back({ v.name + top.open, v.type + top.open, v.offset, top.record });
+        }
+        for (; top.diagnostic < (next ? next->diagnostics : e.diagnostics.size()); ++top.diagnostic)
+        {
+            const Diagnostic& d = e.diagnostics[top.diagnostic];
+            diagnostics.Report(d.code, d.token + top.open, d.expected);
+        }
+        if (!next) { replaying.pop_back(); continue; }
+        ++top.inner;
+        const Replay inner{ &cache.at(next->body), top.open + next->open, none, top.record, top.level + 1, 0, 0, 0, 0 };
+        replaying.push_back(inner);
+    }
+    for (const FreeVariable& f : entry.free) references.push_back({ f.atom, innermost[f.atom] });
+    frame.Replay(entry.extent);
 
-    // After we are done with the body of this nested statement we go back to the parent scope
-    currentScope = nestedScope->parentScope;
+    if (scopeStack.back().body)
+        closed.push_back({ replayed.body, replayed.open, replayed.record, static_cast<uint32_t>(scopes.size()), replayed.variable,
+            static_cast<uint32_t>(variables.size()), replayed.diagnostic, static_cast<uint32_t>(diagnostics.size()) });
+    return true;
 }
 
-void SemanticAnalyzer::Visit(IfStatementNode& n)
+void SemanticAnalyzer::Invalidate(const SyntaxTree& ast)
 {
-    // Visit all if-else if statements under this umbrella if statement and perform semantic analysis
-    for (const auto& ifN : n.ifNodes) ifN->Accept(*this);
-
-    // Make a new nested scope for the body of the else
-    SymbolTable* nestedScope = CreateNewScope(&n, "ELSE_");
+    // A flat tree or a new one shares no nodes with the one cached
+    if (!ast.root) { cache.clear(); return; }
+    std::vector<NodeIndex> dropped;
+    for (const ASTNode* list : ast.changed)
+    {
+        // Cached scopes holding one that was not cached (the root, or a do_while body) are not known
+        const auto it = list == ast.root ? cache.end() : cache.find(list->index);
+        if (it == cache.end()) { cache.clear(); return; }
+        NodeIndex body = it->second.parent;
+
+        // The scopes nested in the list are gone with its old statements
+        dropped.assign(1, list->index);
+        while (!dropped.empty())
+        {
+            const auto gone = cache.find(dropped.back());
+            dropped.pop_back();
+            if (gone == cache.end()) continue;
+            for (const InnerScope& inner : gone->second.inner) dropped.push_back(inner.body);
+            cache.erase(gone);
+        }
+        // The ones it is nested in hold it, they are out of date with it
+        while (body != FlatAST::none)
+        {
+            const auto outer = cache.find(body);
+            if (outer == cache.end()) break;
+            body = outer->second.parent;
+            cache.erase(outer);
+        }
+    }
+}
 
-    // Perform Semantic Analysis to the "contents" of this new scope
-    if (n.elseBody) n.elseBody->Accept(*this);
+bool SemanticAnalyzer::Enter(const NodeIndex key, const ASTNode* node)
+{
+    // The body of a nested statement that was just entered gets its new scope before anything in it is analysed,
+    // unless what it came to last run still holds
+    if (!scopedBodies.empty() && scopedBodies.back().first == key)
+    {
+        const ScopeName name = scopedBodies.back().second;
+        scopedBodies.pop_back();
+        if (node && ReuseScope(*node)) return false;
+        OpenNewScope(name, node);
+        scopeOwners.push_back(key);
+    }
+    return key != skipped;
+}
 
+void SemanticAnalyzer::Exit(const NodeIndex key)
+{
     // After we are done with the body of this nested statement we go back to the parent scope
-    currentScope = nestedScope->parentScope;
+    if (!scopeOwners.empty() && scopeOwners.back() == key)
+    {
+        CloseScope();
+        scopeOwners.pop_back();
+    }
+    // An if statement without an else still gets an (empty) else scope
+    else if (!scopedBodies.empty() && scopedBodies.back().first == key)
+    {
+        OpenNewScope(scopedBodies.back().second);
+        CloseScope();
+        scopedBodies.pop_back();
+    }
 }
 
-void SemanticAnalyzer::Visit(IterationNode& n) { assert(("Semantic Analyzer visited base IterationNode class?!", false)); }
+void SemanticAnalyzer::Visit(IfNode& n)
+{
+    // Identifiers in the condition belong to the current scope, the body gets a new nested scope
+    scopedBodies.emplace_back(n.body->index, ScopeName{ n.elseIf ? "ELSEIF_" : "IF_", n.index });
+}
 
-void SemanticAnalyzer::Visit(WhileNode& n)
+void SemanticAnalyzer::Visit(IfStatementNode& n)
 {
-    // Visit Condition, Identifiers in the condition belong to the current scope
-    n.condition->Accept(*this);
+    // The else scope is made once all the if-else ifs under this umbrella if statement are done
+    scopedBodies.emplace_back(n.elseBody ? n.elseBody->index : n.index, ScopeName{ "ELSE_", n.index });
+}
 
-    // Make a new nested scope for the body of this while
-    SymbolTable* nestedScope = CreateNewScope(&n, "WHILE_");
 
-    // Perform Semantic Analysis to the "contents" of this new scope
-    n.body->Accept(*this);
-
-    // After we are done with the body of this nested statement we go back to the parent scope
-    currentScope = nestedScope->parentScope;
-}
+void SemanticAnalyzer::Visit(WhileNode& n) { scopedBodies.emplace_back(n.body->index, ScopeName{ "WHILE_", n.index }); }
 
 void SemanticAnalyzer::Visit(DoWhileNode& n)
 {
-    // Make a new nested scope for the body of this do_while
-    SymbolTable* nestedScope = CreateNewScope(&n, "DO_");
-
-    // After we are done with the body of this nested statement we go back to the parent scope
-    currentScope = nestedScope->parentScope;
-
-    // Visit Condition. Identifiers in the condition belong to the parent scope (set back above)
-    n.condition->Accept(*this);
+    // Make a new nested scope for the body of this do_while and go straight back to the parent scope.
+    // Identifiers in the condition belong to the parent scope
+    OpenNewScope({ "DO_", n.index });
+    CloseScope();
+    skipped = n.body ? n.body->index : FlatAST::none;
 }
 
-void SemanticAnalyzer::Visit(CompoundStatementNode& n) { for (const auto& statement : n.statements) statement->Accept(*this); }
+// Statements are walked into
+void SemanticAnalyzer::Visit(CompoundStatementNode& n) {}
 
 void SemanticAnalyzer::Visit(StatementBlockNode& n)
 {
-    // Make a new nested scope for the body of this block
-    SymbolTable* nestedScope = CreateNewScope(&n, "BLOCK_");
+    // Make a new nested scope for the body of this block, unless what it came to last run still holds
+    if (ReuseScope(n)) { descend = false; return; }
+    OpenNewScope({ "BLOCK_", n.index }, &n);
+    scopeOwners.push_back(n.index);
+}
 
-    // Visit all the statements in this block
-    for (const auto& statement : n.statements) statement->Accept(*this);
+void SemanticAnalyzer::Visit(DeclareStatementNode& n)
+{
+    frameSlots[n.identifier->index] = DefineVariable(n.type, n.identifier->token);
+    descend = false;  // The identifier is being defined, not looked up
+}
+
+int32_t SemanticAnalyzer::DefineVariable(const TokenIndex typeToken, const TokenIndex identifierToken)
+{
+    // Hiding a definition of an outer scope is fine, one made in this scope already is not. The first definition stands
+    const Atom atom = tokens->GetAtom(identifierToken);
+    const uint32_t shadowed = innermost[atom];
+    if (shadowed != none && shadowed >= scopeStack.back().firstBinding)
+    {
+        diagnostics.Report(DiagnosticCode::Redefinition, identifierToken);
+        return 0;
+    }
 
-    // After we are done with the body of this nested statement block we go back to the parent scope
-    currentScope = nestedScope->parentScope;
+    const int32_t offset = frame.Allocate(GetSlotType(tokens->GetType(typeToken)));
+    innermost[atom] = static_cast<uint32_t>(bindings.size());
+    bindings.push_back({ atom, offset, shadowed, GetValueType(tokens->GetType(typeToken)) });
+    variables.push_back({ identifierToken, typeToken, offset, scopeStack.back().record });
+    return offset;
 }
 
-void SemanticAnalyzer::Visit(DeclareStatementNode& n)
+// The declaration, or the identifier assigned to, is looked up before the value
+void SemanticAnalyzer::Visit(DeclareAssignNode& n)   {}
+void SemanticAnalyzer::Visit(AssignStatementNode& n) {}
+void SemanticAnalyzer::Visit(ReturnStatementNode& n) {}
+
+void SemanticAnalyzer::Visit(EmptyStatementNode& n) {}
+
+bool SemanticAnalyzer::Analyse(const NodeIndex i, const NodeIndex parent)
 {
-    // Look up Declaration Node's type in the symbol table
-    const Symbol* symbolType = currentScope->LookUpSymbol(n.type.str);
-    // Get the variable name from the Declaration's Identifier Node
-    const auto& [variableName, coords, variableType] = n.identifier->token;
-    addressOffset -= 4;  // This shouldnt be hardcoded for int32's but for now we only have ints - FIXME: REFACTOR ADDRESSES
-    // Define a new VarSymbol using variable name and symbolType
-    std::unique_ptr<Symbol> variableSymbol = std::make_unique<VariableSymbol>(variableName, std::to_string(addressOffset), symbolType);
-    n.identifier->offset = std::to_string(addressOffset);
-    if (!currentScope->DefineSymbol(std::move(variableSymbol)))
+    const FlatNode& n = (*flat)[i];
+    switch (n.kind)
     {
-        failState = true;
-        throw SymbolRedefinitionException(n.identifier->token, GetSourceLine ? GetSourceLine(coords.line) : "");
+    case NodeKind::Integer:
+        expressions[i] = ExpressionInfo::Int(flat->GetValue(i));
+        return true;
+    case NodeKind::Identifier:
+    {
+        const Binding* binding = LookUpIdentifier(n.token);
+        frameSlots[i] = binding ? binding->offset : 0;
+        expressions[i] = binding ? ExpressionInfo{ binding->type } : ExpressionInfo{};
+        return true;
+    }
+    case NodeKind::DeclareStatement:
+        frameSlots[n.firstChild] = DefineVariable(n.token, (*flat)[n.firstChild].token);
+        return false;
+    case NodeKind::If:
+        // The first if under the if statement is the IF, the rest are ELSE_IFs
+        scopedBodies.emplace_back(flat->GetSecondChild(i), ScopeName{ (*flat)[parent].firstChild == i ? "IF_" : "ELSEIF_", i });
+        return true;
+    case NodeKind::IfStatement:
+    {
+        // IF and ELSE_IFs come first, whatever follows them is the else body
+        NodeIndex child = n.firstChild;
+        while (child != FlatAST::none && (*flat)[child].kind == NodeKind::If) child = (*flat)[child].nextSibling;
+        scopedBodies.emplace_back(child != FlatAST::none ? child : i, ScopeName{ "ELSE_", i });
+        return true;
+    }
+    case NodeKind::While:
+        scopedBodies.emplace_back(flat->GetSecondChild(i), ScopeName{ "WHILE_", i });
+        return true;
+    case NodeKind::DoWhile:
+        // Condition belongs to the parent scope
+        OpenNewScope({ "DO_", i });
+        CloseScope();
+        skipped = flat->GetSecondChild(i);
+        return true;
+    case NodeKind::StatementBlock:
+        OpenNewScope({ "BLOCK_", i });
+        scopeOwners.push_back(i);
+        return true;
+    default:
+        return true;
     }
 }
 
-void SemanticAnalyzer::Visit(DeclareAssignNode& n)
+// Conditions have no value of their own, the code generator only has them jump: they are the condition of an if or
+// a loop, or make one up together with others
+static bool TakesCondition(const NodeKind parent)
 {
-    n.left->Accept(*this);
-    n.right->Accept(*this);
+    return parent == NodeKind::If || parent == NodeKind::While || parent == NodeKind::DoWhile || parent == NodeKind::Condition;
 }
 
-void SemanticAnalyzer::Visit(AssignStatementNode& n)
+void SemanticAnalyzer::Check(const ASTNode& n, const ASTNode* parent)
 {
-    IdentifierNode* identifier = dynamic_cast<IdentifierNode*>(n.left.get());
-    if (const auto sym = currentScope->LookUpSymbol(identifier->token.str); !sym)
+    switch (n.kind)
+    {
+    case NodeKind::UnaryOperation:
     {
-        failState = true;
-        const auto& [tokName, coords, tokType] = identifier->token;
-        throw SymbolNotFoundException(identifier->token, GetSourceLine ? GetSourceLine(coords.line) : "");
+        const auto& u = static_cast<const UnaryOperationNode&>(n);
+        expressions[n.index] = CheckUnary(tokens->GetType(u.op), expressions[u.expr->index], u.op, diagnostics);
+        return;
+    }
+    case NodeKind::BinaryOperation:
+    case NodeKind::Condition:
+    {
+        const auto& b = static_cast<const BinaryASTNode&>(n);
+        expressions[n.index] = CheckBinary(tokens->GetType(b.op), expressions[b.left->index], expressions[b.right->index], b.op, diagnostics);
+        if (n.kind == NodeKind::Condition && !(parent && TakesCondition(parent->kind))) diagnostics.Report(DiagnosticCode::ConditionAsValue, b.op);
+        return;
+    }
+    case NodeKind::AssignStatement:
+    {
+        const auto& a = static_cast<const AssignStatementNode&>(n);
+        CheckAssignment(a.op, a.left->index, a.right->index);
+        return;
+    }
+    default:
+        return;
     }
-    else identifier->offset = sym->offset;
-    // Identifier's name (left) has been extracted. If we reached here we know the symbol's in the table so no need to visit left node
-    n.right->Accept(*this);
 }
 
-void SemanticAnalyzer::Visit(ReturnStatementNode& n) { n.expr->Accept(*this); }
+void SemanticAnalyzer::Check(const NodeIndex i, const NodeIndex parent)
+{
+    const FlatNode& n = (*flat)[i];
+    switch (n.kind)
+    {
+    case NodeKind::UnaryOperation:
+        expressions[i] = CheckUnary(tokens->GetType(n.token), expressions[n.firstChild], n.token, diagnostics);
+        return;
+    case NodeKind::BinaryOperation:
+    case NodeKind::Condition:
+        expressions[i] = CheckBinary(tokens->GetType(n.token), expressions[n.firstChild], expressions[flat->GetSecondChild(i)], n.token, diagnostics);
+        if (n.kind == NodeKind::Condition && !(parent != FlatAST::none && TakesCondition((*flat)[parent].kind)))
+            diagnostics.Report(DiagnosticCode::ConditionAsValue, n.token);
+        return;
+    case NodeKind::AssignStatement:
+        CheckAssignment(n.token, n.firstChild, flat->GetSecondChild(i));
+        return;
+    default:
+        return;
+    }
+}
 
-void SemanticAnalyzer::Visit(EmptyStatementNode& n) {}
+void SemanticAnalyzer::CheckAssignment(const TokenIndex op, const NodeIndex variable, const NodeIndex value)
+{
+    // A plain assignment converts the value to the variable's type. A compound one (x op= y) is x = x op y, so the
+    // operator has to take both. The variable is never a constant, so this only checks the types
+    if (const TokenID compound = GetCompoundOperator(tokens->GetType(op)); compound != TokenID::UNKNOWN)
+        CheckBinary(compound, expressions[variable], expressions[value], op, diagnostics);
+}
+
+void SemanticAnalyzer::BuildSymbolTables() const
+{
+    const auto name = [](const ScopeName& s) { return s.node == FlatAST::none ? std::string(s.prefix) : Util::GenerateID(s.node, s.prefix); };
+    for (const ScopeRecord& scope : scopes)
+    {
+        symbolTable.push_back(std::make_unique<SymbolTable>(name(scope.name), scope.level));
+        if (scope.parent != none) symbolTable[scope.parent]->DefineSymbol(std::make_unique<NestedScope>(name(scope.name)));
+    }
+    // Built-in types are defined once, globally
+    symbolTable.front()->DefineSymbol(std::make_unique<BuiltInSymbol>(intType.GetName()));
+    for (const VariableRecord& v : variables)
+        symbolTable[v.scope]->DefineSymbol(std::make_unique<VariableSymbol>(std::string(tokens->GetStr(v.name)), v.offset, LookUpType(tokens->GetType(v.type))));
+}
 
 void SemanticAnalyzer::Render(int isOpen) const
 {
     if (!CanRender()) return;
+    if (symbolTable.empty()) BuildSymbolTables();
     for (const auto& scope : symbolTable) scope->Render(isOpen);
 }
 
+void SemanticAnalyzer::Update(SyntaxTree* ast)
+{
+    root = ast->root;
+    flat = &ast->flat;
+    tokens = ast->tokens.get();
+    nodeCount = root ? ast->arena.GetNodeCount() : flat->size();
+    Invalidate(*ast);
+    scopes.clear();
+    variables.clear();
+    symbolTable.clear();
+}
+
 void SemanticAnalyzer::Update()
 {
-    if (!shouldRun || !root) return;
+    if (!shouldRun || (!root && (!flat || flat->empty()))) return;
 
-    Reset();
+    BeginRun();
 
-    try
-    {
-        root->Accept(*this);
-        shouldRun = false;
-    }
-    catch (const std::exception& ex)
-    {
-        failState = true;
-        Logger::Error("{}\n", ex.what());
-    }
+    // Analysis carries on past every error, to report all of them
+    if (root)
+        walker.Walk(*root, [this](ASTNode& n, ASTNode*) { descend = true; return Enter(n.index, &n) && (Dispatch(*this, n), descend); },
+                           [this](ASTNode& n, ASTNode* parent) { Check(n, parent); Exit(n.index); });
+    else
+        walker.Walk(*flat, 0, [this](const NodeIndex i, const NodeIndex parent) { return Enter(i) && Analyse(i, parent); },
+                              [this](const NodeIndex i, const NodeIndex parent) { Check(i, parent); Exit(i); });
+
+    failState = !diagnostics.empty();
+    if (failState) diagnostics.Log(*tokens);
+    else shouldRun = false;
 
     failState ? Logger::Error("Semantic Analysis failed..\n") : Logger::Info("Semantic Analysis Complete\n");
+    if (!failState) Logger::Debug("Stack frame: {} bytes, {} without reusing the slots of closed scopes\n", frame.GetFrameSize(), frame.GetBytesAllocated());
+    Logger::Debug("Scopes: {} reused from the last run, {} analysed\n", scopesReused, scopesAnalysed);
 
     NotifyObservers(Notify::StateStatus);
 }
 
 void SemanticAnalyzer::Reset()
 {
-    failState = false;
-    addressOffset = 0;
+    cache.clear();
+    BeginRun();
+}
 
+void SemanticAnalyzer::BeginRun()
+{
+    failState = false;
+    frame.Clear();
+    diagnostics.Clear();
+    // The nodes of the scopes replayed from the cache keep what they were given when it was made
+    if (cache.empty())
+    {
+        frameSlots.assign(nodeCount, 0);
+        expressions.assign(nodeCount, {});
+    }
+    else
+    {
+        frameSlots.resize(nodeCount, 0);
+        expressions.resize(nodeCount);
+    }
+    scopedBodies.clear();
+    scopeOwners.clear();
+    skipped = FlatAST::none;
+
+    innermost.assign(tokens ? tokens->GetAtomEnd() : 0, none);
+    bindings.clear();
+    scopeStack.clear();
+    scopes.clear();
+    variables.clear();
+    references.clear();
+    closed.clear();
     symbolTable.clear();
-    symbolTable.push_back(std::make_unique<SymbolTable>("GLOBAL_SCOPE", 1));
-    currentScope = symbolTable.back().get();
+    scopesReused = 0;
+    scopesAnalysed = 0;
+    OpenNewScope({ "GLOBAL_SCOPE", FlatAST::none });
     NotifyObservers(Notify::StateStatus);
 }
 
-/* TODO:
-    -Type Checking (no types other than ints atm but for the future)
-*/
\ No newline at end of file
+void SemanticAnalyzer::Benchmark(const int blocks)
+{
+    const auto program = [blocks](const int edited) {
+        std::string text = "int main()\n{\n    int x = 1;\n";
+        for (int i = 0; i < blocks; ++i)
+        {
+            text += "    {\n        int a = x;\n        int b;\n";
+            text += i == edited ? "        b = a * 3;\n" : "        b = a * 2;\n";
+            text += "        if (a < b)\n        {\n            a = a + b;\n        }\n        x = b - a;\n    }\n";
+        }
+        return text + "    return x;\n}\n";
+    };
+
+    TextEditor editor;
+    Lexer lexer(&editor);
+    Parser parser(&lexer);
+    SemanticAnalyzer sem;
+    parser.RegisterObservers(&sem);
+    const auto run = [&]() {
+        lexer.SetToRun();
+        lexer.Update();
+        parser.SetToRun();
+        parser.Update();
+    };
+    const auto analyse = [&sem]() {
+        sem.SetToRun();
+        const auto start = std::chrono::steady_clock::now();
+        sem.Update();
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    editor.SetText(program(-1));
+    run();
+    analyse();
+    if (sem.scopesAnalysed == 0 || !sem.root) { Logger::Warn("Nothing to benchmark the semantic analyzer on\n"); return; }
+
+    // The lexer and parser only redo the block around the edit, and tell the analyzer which one it was
+    editor.SetText(program(blocks / 2));
+    run();
+    const double incremental = analyse();
+    const uint32_t reused = sem.scopesReused;
+    const uint32_t analysed = sem.scopesAnalysed;
+    const std::vector<int32_t> slots = sem.frameSlots;
+    const std::vector<ExpressionInfo> types = sem.expressions;
+    const std::vector<Diagnostic> reported = sem.diagnostics.GetRecords();
+    const uint32_t frameSize = sem.frame.GetFrameSize();
+
+    sem.Reset();
+    const double full = analyse();
+
+    Logger::Info("Semantic analysis of {} scopes after a one line edit: {:.1f} us reusing {} of them and analysing {}, {:.1f} us analysing all of them ({:.1f}x)\n",
+        sem.scopesAnalysed, incremental, reused, analysed, full, full / incremental);
+
+    // Both runs have to come to the same for every node of the tree. The statements the reparse replaced are not in
+    // it any more, only the run that reused scopes kept what they had been given
+    bool same = reused + analysed == sem.scopesAnalysed && frameSize == sem.frame.GetFrameSize() &&
+        std::equal(reported.begin(), reported.end(), sem.diagnostics.GetRecords().begin(), sem.diagnostics.GetRecords().end(),
+            [](const Diagnostic& a, const Diagnostic& b) { return a.code == b.code && a.token == b.token && a.expected == b.expected; });
+    ASTWalker walker;
+    walker.Walk(*sem.root, [&](ASTNode& n, ASTNode*) {
+        const ExpressionInfo& a = types[n.index];
+        const ExpressionInfo& b = sem.expressions[n.index];
+        same = same && slots[n.index] == sem.frameSlots[n.index] && a.type == b.type && a.constant == b.constant && a.value.i == b.value.i;
+        return same;
+    }, [](ASTNode&, ASTNode*) {});
+    if (!same) Logger::Error("Reusing scopes came to a different analysis!\n");
+}
\ No newline at end of file
@@ -1,54 +1,232 @@
+#pragma once
+#include <unordered_map>
+
+#include "Expression.h"
+#include "FrameLayout.h"
 #include "Symbol.h"
 #include "../AST/Visitor.h"
+#include "../AST/ASTWalker.h"
 #include "../AST/AbstractSyntaxTree.h"
+#include "../Util/Error.h"
 #include "../Util/ModuleManager.h"
 
-class SemanticAnalyzer : public ASTNodeVisitor, public IObserver<>, public IObserver<ASTNode>, public Subject<bool>
+// What the analyzer hands its observers after every run
+struct SemanticResult
+{
+    bool failed;
+    // Frame offset (from ebp) of every identifier, keyed by node index. 0 for nodes that are not resolved identifiers
+    const std::vector<int32_t>* frameSlots;
+    uint32_t frameSize;  // Bytes the slots take below ebp
+    // Type of every expression, and its value where it is a constant, keyed by node index
+    const std::vector<ExpressionInfo>* expressions;
+};
+
+class SemanticAnalyzer : public IObserver<>, public IObserver<SyntaxTree>, public Subject<SemanticResult>
 {
 private:
-    std::vector<std::unique_ptr<SymbolTable>> symbolTable;
-    SymbolTable* currentScope;
+    static constexpr uint32_t none = UINT32_MAX;
+
+    // What a scope is called, put together from the ID (index) the parser gave its node only when it is rendered.
+    // The global scope (no node) goes by prefix alone
+    struct ScopeName
+    {
+        const char* prefix;
+        NodeIndex node;
+    };
+    // Every scope opened and every variable defined in a run, in order, for the Semantic Analysis window
+    struct ScopeRecord
+    {
+        ScopeName name;
+        uint32_t parent;  // In scopes, none for the global scope
+        int level;
+    };
+    struct VariableRecord
+    {
+        TokenIndex name;
+        TokenIndex type;
+        int32_t offset;
+        uint32_t scope;
+    };
+    // A definition of an identifier in an open scope, and the one of the same atom it hides
+    struct Binding
+    {
+        Atom atom;
+        int32_t offset;
+        uint32_t shadowed;  // In bindings, none if it hides nothing
+        ValueType type;
+    };
+    struct OpenScope
+    {
+        uint32_t record;        // In scopes
+        uint32_t firstBinding;  // Bindings from here on were made in this scope
+        // Where the run stood when it opened, its cache entry is cut from there once it closes. Null if it is not cached
+        const CompoundStatementNode* body;
+        uint32_t firstVariable;
+        uint32_t firstDiagnostic;
+        uint32_t firstReference;
+        uint32_t firstClosed;
+        uint32_t frameUsed;
+    };
+    // A cached scope that closed (or was replayed) inside the open one, with the records of the run that are its
+    struct ClosedScope
+    {
+        NodeIndex body;
+        TokenIndex open;
+        uint32_t record, recordEnd;
+        uint32_t variable, variableEnd;
+        uint32_t diagnostic, diagnosticEnd;
+    };
+    // An identifier looked up in an open scope, to what. Cut down to the ones defined outside of it as each scope closes
+    struct Reference
+    {
+        Atom atom;
+        uint32_t binding;  // In bindings, none if it is not declared
+    };
+    // What an identifier defined outside of a cached scope resolved to. Offset 0 and no type if it was not declared
+    struct FreeVariable
+    {
+        Atom atom;
+        int32_t offset;
+        ValueType type;
+    };
+    // Where a cached scope nested in another one came among the records of the outer one
+    struct InnerScope
+    {
+        NodeIndex body;
+        TokenIndex open;  // Relative to the outer scope's
+        uint32_t scopes;
+        uint32_t variables;
+        uint32_t diagnostics;
+    };
+    // The analysis of a scope whose body is a statement list, kept for the next run. A scope that is the same nodes, in
+    // the same environment (frame use and free variables), comes to the same again and is not walked. Its tokens are kept
+    // relative to the body's open bracket, an edit before it moves everything in it along with it
+    struct ScopeCache
+    {
+        NodeIndex parent;  // Body of the cached scope it is nested in, none at the top
+        uint32_t frameUsed;
+        std::vector<FreeVariable> free;
+        // Only what it added to the run itself, the cached scopes nested in it have their own entries. The scopes in it
+        // that are not cached have nothing in them (a do_while's, an if's missing else), so its variables are all in
+        // its own scope, named first
+        std::vector<ScopeName> scopes;
+        std::vector<VariableRecord> variables;
+        std::vector<Diagnostic> diagnostics;
+        std::vector<InnerScope> inner;
+        FrameExtent extent;
+    };
+    // A cached scope being replayed, and how far
+    struct Replay
+    {
+        const ScopeCache* entry;
+        TokenIndex open;
+        uint32_t record;  // Its own, in scopes
+        uint32_t parent;
+        int level;
+        uint32_t scope, variable, diagnostic, inner;
+    };
+
+    BuiltInSymbol intType { "int" };
+
+    // All the open scopes share one table: an identifier resolves to innermost[its atom], whatever
+    // the nesting depth. Closing a scope drops its bindings and restores the ones they had shadowed
+    std::vector<uint32_t> innermost;
+    std::vector<Binding> bindings;
+    std::vector<OpenScope> scopeStack;
+    std::vector<ScopeRecord> scopes;
+    std::vector<VariableRecord> variables;
+    std::vector<Reference> references;
+    std::vector<ClosedScope> closed;
+    std::vector<Replay> replaying;
+    // Keyed by body node. Statement lists the parser replaces, and the ones they are nested in, are dropped
+    std::unordered_map<NodeIndex, ScopeCache> cache;
+    uint32_t scopesReused = 0;
+    uint32_t scopesAnalysed = 0;
+    // The per scope tables rendered, built from the records the first time they are rendered after a run
+    mutable std::vector<std::unique_ptr<SymbolTable>> symbolTable;
 
     ASTNode* root = nullptr;
+    FlatAST* flat = nullptr;
+    const TokenStream* tokens = nullptr;
+    size_t nodeCount = 0;
+
+    ASTWalker walker;
+    // Bodies of the nested statements being walked that open a new scope once entered, with its name
+    std::vector<std::pair<NodeIndex, ScopeName>> scopedBodies;
+    // Nodes whose scope closes when they are exited, innermost last
+    std::vector<NodeIndex> scopeOwners;
+    NodeIndex skipped = FlatAST::none;  // Body of the last do_while, which is not analysed
+    bool descend = true;                // Cleared by the nodes whose children are not to be walked
 
-    int addressOffset = 0;
+    // Side table keyed by the tree's (or the FlatAST's) node indices
+    std::vector<int32_t> frameSlots;
+    std::vector<ExpressionInfo> expressions;
+    FrameLayout frame;
+    Diagnostics diagnostics;
     bool failState = false;
     bool shouldRun = false;
 
-    SymbolTable* CreateNewScope(const ASTNode* n, const char* tag);
+    void OpenNewScope(const ScopeName& name, const ASTNode* body = nullptr);  // Cached if body is a statement list
+    void CloseScope();
+    void StoreScope(const OpenScope& scope, const FrameExtent& extent);
+    bool ReuseScope(const ASTNode& body);  // Replays body's cached analysis instead, if it still holds
+    void Invalidate(const SyntaxTree& ast);
+    void BeginRun();  // Clears the last run's results, but not what is cached
+    const Binding* LookUpIdentifier(const TokenIndex token);  // Null (and reported) if it is not declared
+    int32_t DefineVariable(const TokenIndex typeToken, const TokenIndex identifierToken);  // Returns the variable's frame offset
+    const Symbol* LookUpType(const TokenID type) const { return type == TokenID::INT_TYPE ? &intType : nullptr; }
+    void BuildSymbolTables() const;
+
+    // Scope bookkeeping around every node entered and exited, keyed by node index
+    bool Enter(const NodeIndex key, const ASTNode* node = nullptr);  // False for nodes not to be analysed
+    void Exit(const NodeIndex key);
+    // The same analysis over a FlatAST, returns whether to walk node i's children
+    bool Analyse(const NodeIndex i, const NodeIndex parent);
+    // Types (and folds) an operator or checks an assignment once its operands are done, for tree and FlatAST nodes
+    void Check(const ASTNode& n, const ASTNode* parent);
+    void Check(const NodeIndex i, const NodeIndex parent);
+    void CheckAssignment(const TokenIndex op, const NodeIndex variable, const NodeIndex value);
 public:
     void Render(int isOpen) const;
-    bool CanRender() const { return !(failState || !root || symbolTable.empty()); }
-
-    // Inherited via ASTNodeVisitor
-    void Visit(ASTNode& n)               override;
-    void Visit(UnaryASTNode& n)          override;
-    void Visit(BinaryASTNode& n)         override;
-    void Visit(IntegerNode& n)           override;
-    void Visit(IdentifierNode& n)        override;
-    void Visit(UnaryOperationNode& n)    override;
-    void Visit(BinaryOperationNode& n)   override;
-    void Visit(ConditionNode& n)         override;
-    void Visit(IfNode& n)                override;
-    void Visit(IfStatementNode& n)       override;
-    void Visit(IterationNode& n)         override;
-    void Visit(WhileNode& n)             override;
-    void Visit(DoWhileNode& n)           override;
-    void Visit(StatementBlockNode& n)    override;
-    void Visit(CompoundStatementNode& n) override;
-    void Visit(DeclareStatementNode& n)  override;
-    void Visit(DeclareAssignNode& n)     override;
-    void Visit(AssignStatementNode& n)   override;
-    void Visit(ReturnStatementNode& n)   override;
-    void Visit(EmptyStatementNode& n)    override;
+    const Diagnostics& GetDiagnostics() const { return diagnostics; }
+    // Of the last run: scopes whose analysis was replayed from the cache, and scopes walked
+    uint32_t GetScopesReused()   const { return scopesReused; }
+    uint32_t GetScopesAnalysed() const { return scopesAnalysed; }
+    bool CanRender() const { return !(failState || (!root && (!flat || flat->empty())) || scopes.empty()); }
+    // Times the semantic pass after a one line edit in the middle of a generated program of ten line blocks (10k lines
+    // for the default 1000), once reusing the scopes the edit did not touch and once analysing them all again, and checks
+    // both came to the same frame slots, types and diagnostics. Runs modules of its own, the editor's program is left alone
+    static void Benchmark(const int blocks = 1000);
+
+    // Visited through Dispatch
+    void Visit(IntegerNode& n);
+    void Visit(IdentifierNode& n);
+    void Visit(UnaryOperationNode& n);
+    void Visit(BinaryOperationNode& n);
+    void Visit(ConditionNode& n);
+    void Visit(IfNode& n);
+    void Visit(IfStatementNode& n);
+    void Visit(WhileNode& n);
+    void Visit(DoWhileNode& n);
+    void Visit(StatementBlockNode& n);
+    void Visit(CompoundStatementNode& n);
+    void Visit(DeclareStatementNode& n);
+    void Visit(DeclareAssignNode& n);
+    void Visit(AssignStatementNode& n);
+    void Visit(ReturnStatementNode& n);
+    void Visit(EmptyStatementNode& n);
 
     // Inherited via IObserver Interface
     virtual bool ShouldRun()  const override { return shouldRun; }
     virtual void SetToRun()         override { shouldRun = true; }
-    virtual void Update(ASTNode* n) override { root = n; symbolTable.clear(); }
+    virtual void Update(SyntaxTree* ast) override;
     virtual void Update()           override;
     virtual void Reset()            override;
 
     // Inherited via Subject
-    virtual void NotifyObservers(const Notify what) override { for (auto& obs : observers) obs->Update(&failState); }
+    virtual void NotifyObservers(const Notify what) override
+    {
+        SemanticResult result{ failState, &frameSlots, frame.GetFrameSize(), &expressions };
+        for (auto& obs : observers) obs->Update(&result);
+    }
 };
\ No newline at end of file
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <memory>
 #include <map>
@@ -8,14 +9,14 @@ class Symbol
 {
 protected:
     std::string name;
-    std::string offset;
+    int32_t offset;  // From ebp, 0 for symbols that are not variables
     // The Symbol of an identifier - not all identifiers have a symbol
     // BuiltIn Type Definitions and Nested Scopes in a symbol table dont have a type, just a name
     const Symbol* type;   
     friend class SymbolTable;
     friend class SemanticAnalyzer;
 public:
-    Symbol(const std::string& n, const std::string& off = "0", const Symbol* t = nullptr) : name(n), offset(off), type(t) {}
+    Symbol(const std::string& n, const int32_t off = 0, const Symbol* t = nullptr) : name(n), offset(off), type(t) {}
     virtual ~Symbol() = default;
 
     std::string GetName() const { return name; }
@@ -38,7 +39,7 @@ public:
 class VariableSymbol : public Symbol
 {
 public:
-    VariableSymbol(const std::string& n, const std::string& off, const Symbol* t) : Symbol(n, off, t) {}
+    VariableSymbol(const std::string& n, const int32_t off, const Symbol* t) : Symbol(n, off, t) {}
     virtual ~VariableSymbol() = default;
 
     virtual void Render() const override;
@@ -57,21 +58,19 @@ public:
 // class FunctionSymbol : public Symbol ...
 // class UserDefinedSymbol : public Symbol ...
 
-// Abstract Data Type for tracking various symbols in the source code
-// Each SymbolTable represents a scope in the source code
+// The symbols of one scope in the source code, as the Semantic Analysis window shows them.
+// Analysis itself resolves identifiers through a single table of bindings (see SemanticAnalyzer),
+// these are put together from what it recorded only when they are to be rendered
 class SymbolTable
 {
 private:
     std::map<std::string, std::unique_ptr<Symbol>> symbols;
     const std::string scopeName;
     const int scopeLevel;
-    SymbolTable* parentScope;
-    friend class SemanticAnalyzer;
 public:
-    SymbolTable(const std::string& name, const int level, SymbolTable* parent = nullptr);
+    SymbolTable(const std::string& name, const int level) : scopeName(name), scopeLevel(level) {}
 
     [[maybe_unused]] bool DefineSymbol(std::unique_ptr<Symbol> s);
-    const Symbol* LookUpSymbol(const std::string& symName) const;
 
     void Render(int isOpen) const;
 };
\ No newline at end of file
@@ -1,22 +1,49 @@
+#include <magic_enum.hpp>
+#include <sstream>
+
 #include "Error.h"
+#include "Logger.h"
+#include "../Lexer/TokenStream.h"
 
-std::string BuildSourceErrorInfo(const Token& tok, const std::string& srcCode)
+static std::string BuildSourceErrorInfo(const Token& tok, const TokenCoords coords, const std::string_view srcCode)
 {
     static const std::string sourceTag = "<source> ";
     static const std::string seperator = "\t|\t\t";
 
-    const auto& [name, coords, type] = tok;
     const std::string errorLoc { sourceTag + std::to_string(coords.line) + ':' + std::to_string(coords.col) + ' ' };
     std::string errorMarker;
     std::stringstream ss;
 
-    if (srcCode != "")
-        errorMarker.append(coords.col - 1, ' ').append("^").append(tok.str.size() - 1, '~');
+    if (!srcCode.empty())
+        errorMarker.append(coords.col - 1, ' ').append("^").append(tok.str.size() > 1 ? tok.str.size() - 1 : 0, '~');
     ss << errorLoc  << '\n' << seperator << srcCode << '\n' << seperator << errorMarker;
 
     return ss.str();
 }
 
-std::string UnexpectedTokenException::errorMsg = "[PARSER ERROR]: Encountered unexpected Token ";
-std::string SymbolNotFoundException::errorMsg = "[SEMANTIC ERROR]: Redefinition of identifier ";
-std::string SymbolRedefinitionException::errorMsg = "[SEMANTIC ERROR]: Redefinition of identifier ";
\ No newline at end of file
+std::string Diagnostics::Format(const Diagnostic& d, const TokenStream& tokens)
+{
+    const Token tok = tokens[d.token];
+    const TokenCoords coords = tokens.GetCoords(d.token);
+    std::string msg;
+    switch (d.code)
+    {
+    case DiagnosticCode::UnexpectedToken:      msg = "[PARSER ERROR]: Encountered unexpected Token ";     break;
+    case DiagnosticCode::LiteralOutOfRange:    msg = "[PARSER ERROR]: Integer literal out of range ";     break;
+    case DiagnosticCode::UndeclaredIdentifier: msg = "[SEMANTIC ERROR]: Use of undeclared identifier ";   break;
+    case DiagnosticCode::Redefinition:         msg = "[SEMANTIC ERROR]: Redefinition of identifier ";     break;
+    case DiagnosticCode::InvalidOperands:      msg = "[SEMANTIC ERROR]: Invalid operands to ";            break;
+    case DiagnosticCode::ConditionAsValue:     msg = "[SEMANTIC ERROR]: Condition used as a value in ";   break;
+    case DiagnosticCode::Overflow:             msg = "[SEMANTIC ERROR]: Constant overflows in ";          break;
+    case DiagnosticCode::DivisionByZero:       msg = "[SEMANTIC ERROR]: Division by zero in ";            break;
+    case DiagnosticCode::InvalidShift:         msg = "[SEMANTIC ERROR]: Shift count out of range in ";    break;
+    }
+    msg += '\'' + std::string(tok.str) + '\'';
+    if (d.expected != TokenID::UNKNOWN) msg += std::string(" (expected ") + magic_enum::enum_name(d.expected).data() + ')';
+    return msg + " at " + BuildSourceErrorInfo(tok, coords, tokens.GetLine(coords.line));
+}
+
+void Diagnostics::Log(const TokenStream& tokens) const
+{
+    for (const Diagnostic& d : records) Logger::Error("{}\n", Format(d, tokens));
+}
\ No newline at end of file
@@ -1,32 +1,39 @@
 #pragma once
-#include <sstream>
+#include <cstdint>
+#include <string>
+#include <vector>
+
 #include "../Lexer/Token.h"
 
-std::string BuildSourceErrorInfo(const Token& tok, const std::string& srcCode);
+class TokenStream;
 
-class UnexpectedTokenException : public std::exception
-{
-private:
-    static std::string errorMsg;
-public:
-    UnexpectedTokenException(const Token& tok, const std::string&& errorSrc) 
-        : exception((errorMsg + '\'' + tok.str + "\' at " + BuildSourceErrorInfo(tok, errorSrc)).c_str()) {}
-};
+// What went wrong. The messages are only put together when the diagnostics are displayed
+enum class DiagnosticCode : uint8_t { UnexpectedToken, LiteralOutOfRange, UndeclaredIdentifier, Redefinition, InvalidOperands, ConditionAsValue, Overflow, DivisionByZero, InvalidShift };
 
-class SymbolNotFoundException : public std::exception
+// An error as it is recorded, cheap enough to report wherever one is found
+struct Diagnostic
 {
-private:
-    static std::string errorMsg;
-public:
-    SymbolNotFoundException(const Token& tok, const std::string&& errorSrc)
-        : exception((errorMsg + '\'' + tok.str + "\' at " + BuildSourceErrorInfo(tok, errorSrc)).c_str()) {}
+    DiagnosticCode code;
+    TokenID expected;  // What the parser was looking for instead, UNKNOWN when there was no single token it could be
+    TokenIndex token;  // Where it was found
 };
 
-class SymbolRedefinitionException : public std::exception
+// Every error a pass found in a run, in the order it found them
+class Diagnostics
 {
 private:
-    static std::string errorMsg;
+    std::vector<Diagnostic> records;
 public:
-    SymbolRedefinitionException(const Token& tok, const std::string&& errorSrc)
-        : exception((errorMsg + '\'' + tok.str + "\' at " + BuildSourceErrorInfo(tok, errorSrc)).c_str()) {}
+    void Report(const DiagnosticCode code, const TokenIndex token, const TokenID expected = TokenID::UNKNOWN) { records.push_back({ code, expected, token }); }
+    void Clear() { records.clear(); }
+
+    bool empty()                                const { return records.empty(); }
+    size_t size()                               const { return records.size(); }
+    const std::vector<Diagnostic>& GetRecords() const { return records; }
+
+    // The message for d, pointing at its token on the source line it is on. The line comes from the stream's
+    // line index, so this touches nothing but tokens and is safe to call from any thread
+    static std::string Format(const Diagnostic& d, const TokenStream& tokens);
+    // Logs every diagnostic as an error
+    void Log(const TokenStream& tokens) const;
 };
\ No newline at end of file
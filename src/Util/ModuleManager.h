@@ -1,6 +1,6 @@
 #pragma once
+#include <algorithm>
 #include <vector>
-#include <functional>
 
 class ASTNode;
 enum class Notify { ShouldRun, ToReset, Run, ASTChanged, StateStatus };
@@ -16,11 +16,8 @@ public:
 template<>
 class IObserver<void>
 {
-protected:
-	std::function<std::string(const int)> GetSourceLine;
 public:
 	virtual ~IObserver() = default;
-	virtual void SetCallback(std::function<std::string(const int)> callback) { GetSourceLine = callback; }
 	virtual bool ShouldRun() const = 0;
 	virtual void SetToRun() = 0;
 	virtual void Update() = 0;
@@ -66,11 +63,6 @@ public:
 		}
 	}
 
-	void UpdateGetSourceLineCallback(std::function<std::string(const int)> callback)
-	{
-		for (auto obs : observers) obs->SetCallback(callback);
-	}
-
 	void RunModulesUpTo(IObserver<void>* obs)
 	{
 		for (auto it = observers.begin(); it != std::next(std::find(observers.begin(), observers.end(), obs)); ++it)
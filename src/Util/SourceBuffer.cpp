@@ -0,0 +1,88 @@
+#include <fstream>
+#include <iterator>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "SourceBuffer.h"
+
+SourceBuffer::~SourceBuffer()
+{
+    if (!mapped) return;
+#ifdef _WIN32
+    UnmapViewOfFile(mapped);
+#else
+    munmap(const_cast<char*>(mapped), mappedSize);
+#endif
+}
+
+std::shared_ptr<const SourceBuffer> SourceBuffer::FromFile(const std::string& path)
+{
+    auto buffer = std::make_shared<SourceBuffer>();
+    if (!buffer->Map(path) && !buffer->Read(path)) return nullptr;
+    return buffer;
+}
+
+bool SourceBuffer::Map(const std::string& path)
+{
+#ifdef _WIN32
+    const HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER fileSize;
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    if (GetFileType(file) != FILE_TYPE_DISK || !GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0 || fileSize.QuadPart % info.dwPageSize == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    // The view keeps the mapping alive on its own, neither handle is needed past this point
+    const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) return false;
+    mapped = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    CloseHandle(mapping);
+    if (!mapped) return false;
+    mappedSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    const long pageSize = sysconf(_SC_PAGESIZE);
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0 || st.st_size % pageSize == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    // The rest of the last page reads as zeros, that is the '\0' after the text
+    void* const view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) return false;
+    madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+    mapped = static_cast<const char*>(view);
+    mappedSize = static_cast<size_t>(st.st_size);
+#endif
+    text = std::string_view(mapped, mappedSize);
+    return true;
+}
+
+bool SourceBuffer::Read(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    owned.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    text = owned;
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Read-only source text, either memory-mapped from a file or held in memory. The text is always followed by a '\0'
+// the lexer relies on. Files are mapped where possible, anything that cannot be (pipes, or files ending exactly on
+// a page boundary, which leaves no room for the '\0') is read in a single go instead.
+class SourceBuffer
+{
+private:
+    std::string owned;
+    const char* mapped = nullptr;
+    size_t mappedSize = 0;
+    std::string_view text;
+
+    bool Map(const std::string& path);
+    bool Read(const std::string& path);
+public:
+    SourceBuffer() : text(owned) {}
+    explicit SourceBuffer(std::string src) : owned(std::move(src)), text(owned) {}
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+    ~SourceBuffer();
+
+    // nullptr if the file could not be opened
+    static std::shared_ptr<const SourceBuffer> FromFile(const std::string& path);
+
+    std::string_view GetText() const { return text; }
+    size_t size()              const { return text.size(); }
+    bool IsMapped()            const { return mapped != nullptr; }
+};
\ No newline at end of file
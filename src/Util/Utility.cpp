@@ -1,4 +1,3 @@
-#include <sstream>
 #include <fstream>
 #include <functional>
 #include <imgui.h>
@@ -11,14 +10,7 @@
 // General Helpers
 namespace Util
 {
-    std::string GenerateID(const ASTNode* node, const char* ID)
-    {
-        std::stringstream ss;
-        ss << static_cast<const void*>(node);
-        std::string id = ss.str();
-        id.insert(0, ID);
-        return id;
-    }
+    std::string GenerateID(const uint32_t nodeIndex, const char* ID) { return ID + std::to_string(nodeIndex); }
 }
 
 // GUI Helpers
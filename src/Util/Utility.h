@@ -1,10 +1,9 @@
 #pragma once
 
-class ASTNode;
-
 namespace Util // General Helpers
 {
-    std::string GenerateID(const ASTNode* node, const char* ID);
+    // Readable name of a node, for rendering only. The node's ID is its index, given when it was parsed
+    std::string GenerateID(const uint32_t nodeIndex, const char* ID);
 }
 
 namespace GUI  // GUI Helpers
@@ -11,16 +11,69 @@
 
 #include <magic_enum.hpp>
 
+#include <chrono>
+#include <future>
+#include <iostream>
+
 #include "Parser/Parser.h"
 #include "Semantics/SemanticAnalyzer.h"
 #include "AST/ASTVisualizer.h"
 #include "AST/ASTPrinterJson.h"
 #include "CodeGen/CodeGenerator.h"
 #include "Util/Logger.h"
+#include "Util/SourceBuffer.h"
 #include "Util/Utility.h"
 
-int main()
+// Batch mode: compiles the file given on the command line without opening a window and prints the generated code
+static int RunBatch(const std::string& path)
+{
+    const auto buffer = SourceBuffer::FromFile(path);
+    if (!buffer)
+    {
+        std::cerr << "Cannot read file " << path << '\n';
+        return 1;
+    }
+
+    TextEditor editor;
+    Lexer lexer(&editor);
+    Parser parser(&lexer);
+    SemanticAnalyzer sem;
+    CodeGenerator codeGen;
+    ModuleManager::Instance()->RegisterObservers(&lexer, &parser, &sem, &codeGen);
+    parser.RegisterObservers(&sem, &codeGen);
+    sem.RegisterObservers(&codeGen);
+
+    // Lexed straight from the mapped file, the editor is never filled
+    lexer.SetSource(buffer);
+    ModuleManager::Instance()->NotifyObservers(Notify::ShouldRun);
+    ModuleManager::Instance()->RunModulesUpTo(&codeGen);
+
+    const std::string tac = codeGen.GetTAC();
+    if (tac.empty()) return 1;
+    std::cout << tac << '\n' << codeGen.Getx86();
+    return 0;
+}
+
+// Splits a file's text into the editor's lines, dropping '\r' of "\r\n" line endings
+static std::vector<std::string> SplitLines(const std::string_view text)
+{
+    std::vector<std::string> lines;
+    size_t start = 0;
+    while (start <= text.size())
+    {
+        size_t end = text.find('\n', start);
+        if (end == std::string_view::npos) end = text.size();
+        const size_t len = end > start && text[end - 1] == '\r' ? end - start - 1 : end - start;
+        lines.emplace_back(text.substr(start, len));
+        start = end + 1;
+    }
+    return lines;
+}
+
+int main(int argc, char** argv)
 {
+    if (argc > 1) return RunBatch(argv[1]);
+
     sf::RenderWindow window(sf::VideoMode().getDesktopMode(), "EditorTest");
     window.setVerticalSyncEnabled(true);
 
@@ -35,6 +88,9 @@ int main()
     editor.SetShowWhitespaces(false);
     std::string filePath;
     std::string fileName = "Untitled";
+    // Lines of a file being opened, split on a worker thread while the lexer already works on the file itself
+    std::future<std::vector<std::string>> loadingLines;
+    bool wasReadOnly = false;
 
     ImGuiFileDialog::Instance()->SetExtentionInfos(".cpp", ImVec4(1.0f, 1.0f, 0.0f, 0.9f));
     ImGuiFileDialog::Instance()->SetExtentionInfos(".h",   ImVec4(0.0f, 1.0f, 0.0f, 0.9f));
@@ -50,19 +106,22 @@ int main()
     // Registering order MATTERS - should mirror the order they should be run in
     ModuleManager::Instance()->RegisterObservers(&lexer, &parser, &sem, &codeGen);
 
-    // Set callback for all registered modules that enables them to get back the line text from an error location
-    ModuleManager::Instance()->UpdateGetSourceLineCallback([&editor](const int line) {
-        const auto currentCoords = editor.GetCursorPosition();
-        editor.SetCursorPosition({ line - 1, 0 });
-        std::string sourceLine = editor.GetCurrentLineText();
-        editor.SetCursorPosition(currentCoords);
-        return sourceLine;
-    });
-
     ASTPrinterJson jsonPrinter;
     // Pass extra stuff to the ASTVisualizer to render
-    astViz.SetExtrasToRender([&jsonPrinter]() {
+    astViz.SetExtrasToRender([&jsonPrinter, &parser]() {
+        ImGui::SameLine();
+        bool flat = parser.IsFlat();
+        if (ImGui::Checkbox("Flat AST", &flat))
+        {
+            // Reparse straight away so every module moves over to the other representation
+            parser.SetFlat(flat);
+            ModuleManager::Instance()->NotifyObservers(Notify::ShouldRun);
+            ModuleManager::Instance()->RunModulesUpTo(&parser);
+        }
         ImGui::SameLine();
+        if (ImGui::Button("Memory")) parser.BenchmarkMemory();
+        ImGui::SameLine();
+        if (ImGui::Button("Dispatch")) parser.BenchmarkDispatch();
         static float width = 100.0f;
         float pos = width + ImGui::GetStyle().ItemSpacing.x;
         ImGui::SameLine(ImGui::GetWindowWidth() - pos);
@@ -185,6 +244,11 @@ int main()
         ImGui::Separator();
         ImGui::Spacing();
         
+        if (loadingLines.valid() && loadingLines.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            editor.SetTextLines(loadingLines.get());
+            editor.SetReadOnly(wasReadOnly);
+        }
         // Module notification HAS to happen before the editor is rendered since changed flag is reset
         if (editor.IsTextChanged()) ModuleManager::Instance()->NotifyObservers(Notify::ShouldRun);
         editor.Render("TextEditor");
@@ -192,6 +256,14 @@ int main()
 
         static ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable | ImGuiTableFlags_Hideable;
         ImGui::Begin("Lexer Output");
+        bool tableDriven = lexer.GetEngine() == Lexer::Engine::TableDriven;
+        if (ImGui::Checkbox("Table-driven lexer", &tableDriven)) lexer.SetEngine(tableDriven ? Lexer::Engine::TableDriven : Lexer::Engine::HandWritten);
+        ImGui::SameLine();
+        bool streaming = lexer.IsStreaming();
+        if (ImGui::Checkbox("Stream to parser", &streaming)) lexer.SetStreaming(streaming);
+        ImGui::SameLine();
+        if (ImGui::Button("Benchmark")) lexer.Benchmark();
+        ImGui::Separator();
         if (ImGui::BeginTable("Tokens", 3, flags))
         {
             // To freeze the first row of the table we need the ImGuiTableFlags_ScrollY flag
@@ -201,16 +273,23 @@ int main()
             ImGui::TableSetupColumn("Line:Column");
             ImGui::TableHeadersRow();
             const auto& tokens = lexer.GetTokens();
-            for (int row = 0; row < tokens.size(); row++)
+            // Only the visible rows are submitted, so only their coordinates get resolved
+            ImGuiListClipper clipper;
+            clipper.Begin(static_cast<int>(tokens.size()));
+            while (clipper.Step())
             {
-                ImGui::TableNextRow();
-                const auto& [str, coords, type] = tokens.at(row);
-                ImGui::TableSetColumnIndex(0);
-                ImGui::Text("%s", str.c_str());
-                ImGui::TableSetColumnIndex(1);
-                ImGui::Text("%s", magic_enum::enum_name(type).data());
-                ImGui::TableSetColumnIndex(2);
-                ImGui::Text("%d:%d", coords.line, coords.col);
+                for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
+                {
+                    ImGui::TableNextRow();
+                    const std::string_view str = tokens.GetStr(row);
+                    const TokenCoords coords = tokens.GetCoords(row);
+                    ImGui::TableSetColumnIndex(0);
+                    ImGui::TextUnformatted(str.data(), str.data() + str.size());
+                    ImGui::TableSetColumnIndex(1);
+                    ImGui::Text("%s", magic_enum::enum_name(tokens.GetType(row)).data());
+                    ImGui::TableSetColumnIndex(2);
+                    ImGui::Text("%d:%d", static_cast<int>(coords.line), static_cast<int>(coords.col));
+                }
             }
             ImGui::EndTable();
         }
@@ -223,8 +302,10 @@ int main()
         int open_action = -1;
         if (ImGui::Begin("Semantic Analysis"))
         {
+            if (ImGui::Button("Benchmark")) SemanticAnalyzer::Benchmark();
             if (sem.CanRender())
             {
+                ImGui::SameLine();
                 if (ImGui::Button("Expand Scopes"))   open_action = 1;
                 ImGui::SameLine();
                 if (ImGui::Button("Collapse Scopes")) open_action = 0;
@@ -251,6 +332,7 @@ int main()
         // Code Gen Window (TAC & 'Assembly')
         if (ImGui::Begin("Code Generation"))
         {
+            if (ImGui::Button("Benchmark")) codeGen.Benchmark();
             if (ImGui::BeginTabBar("##tabs", ImGuiTabBarFlags_None))
             {
                 ImGui::PushStyleColor(ImGuiCol_FrameBg, 0);
@@ -278,17 +360,17 @@ int main()
         {
             if (ImGuiFileDialog::Instance()->IsOk())
             {
-                std::ifstream infile;
-                filePath = ImGuiFileDialog::Instance()->GetFilePathName();
-                infile.open(filePath);
-                if (infile)
+                const std::string path = ImGuiFileDialog::Instance()->GetFilePathName();
+                if (auto buffer = SourceBuffer::FromFile(path))
                 {
-                    std::vector<std::string> lines;
-                    std::string line;
-                    while (std::getline(infile, line)) lines.push_back(line);
-                    editor.SetTextLines(lines);
+                    filePath = path;
                     fileName = ImGuiFileDialog::Instance()->GetCurrentFileName();
-                    infile.close();
+                    lexer.SetSource(buffer);
+                    ModuleManager::Instance()->NotifyObservers(Notify::ShouldRun);
+                    // Editor stays read-only until it has the file's lines, edits before that would be lost
+                    if (!loadingLines.valid()) wasReadOnly = editor.IsReadOnly();
+                    editor.SetReadOnly(true);
+                    loadingLines = std::async(std::launch::async, [buffer]() { return SplitLines(buffer->GetText()); });
                 }
                 else ImGui::OpenPopup("Error");
             }